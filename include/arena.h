@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+// passes the allocations to upstream and counts the allocated bytes, the
+// deallocated ones are not subtracted, so behind a monotonic resource the
+// count is the footprint of the arena
+class CountingResource : public std::pmr::memory_resource {
+    public:
+    CountingResource(std::pmr::memory_resource* upstream) : upstream(upstream), allocated(0) { }
+
+    size_t allocated_bytes() const {
+        return allocated;
+    }
+
+    void reset_count() {
+        allocated = 0;
+    }
+
+    private:
+    std::pmr::memory_resource* upstream;
+    size_t allocated;
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        allocated += bytes;
+        return upstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        upstream->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+// monotonic arena with preallocated initial buffer, everything allocated
+// from it is freed at once by reset. A run which outgrew the buffer took
+// more from upstream, reset then grows the buffer to the peak so the next
+// runs fit.
+class Arena {
+    public:
+    Arena(size_t initial_size)
+        // not value initialized, the pages are touched only when used
+        : buffer(new std::byte[initial_size])
+        , size(initial_size)
+        , monotonic(std::in_place, buffer.get(), initial_size)
+        , counter(&*monotonic)
+        , peak(0)
+    { }
+
+    std::pmr::memory_resource* resource() {
+        return &counter;
+    }
+
+    void reset() {
+        peak = std::max(peak, counter.allocated_bytes());
+        counter.reset_count();
+        monotonic->release();
+        if (peak > size) {
+            // the counter doesn't see the alignment padding
+            grow(peak + peak / 16);
+        }
+    }
+
+    // the most bytes used by one run between resets
+    size_t peak_bytes() const {
+        return std::max(peak, counter.allocated_bytes());
+    }
+
+    size_t buffer_size() const {
+        return size;
+    }
+
+    private:
+    std::unique_ptr<std::byte[]> buffer;
+    size_t size;
+    // replaced with the buffer, the counter keeps pointing to it
+    std::optional<std::pmr::monotonic_buffer_resource> monotonic;
+    CountingResource counter;
+    size_t peak;
+
+    void grow(size_t new_size) {
+        monotonic.reset();
+        buffer.reset(new std::byte[new_size]);
+        size = new_size;
+        monotonic.emplace(buffer.get(), size);
+    }
+};
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Set of indexes smaller than size with fast lookup of the smallest one.
+// Every level has a bit for each non-zero word of the level below, so the
+// smallest index is found with one countr_zero per level.
+class HierarchicalBitmap {
+    public:
+    HierarchicalBitmap(size_t size) {
+        do {
+            size = (size + 63) / 64;
+            levels.emplace_back(size, 0);
+        } while (size > 1);
+    }
+
+    bool empty() const {
+        return levels.back()[0] == 0;
+    }
+
+    void set(size_t i) {
+        for (auto& level : levels) {
+            auto& word = level[i / 64];
+            bool was_zero = word == 0;
+            word |= uint64_t{1} << (i % 64);
+            if (!was_zero) {
+                break;
+            }
+            i /= 64;
+        }
+    }
+
+    void reset(size_t i) {
+        for (auto& level : levels) {
+            auto& word = level[i / 64];
+            word &= ~(uint64_t{1} << (i % 64));
+            if (word != 0) {
+                break;
+            }
+            i /= 64;
+        }
+    }
+
+    // expects non-empty set
+    size_t first() const {
+        size_t i = 0;
+        for (size_t l = levels.size(); l-- > 0; ) {
+            i = i * 64 + std::countr_zero(levels[l][i]);
+        }
+        return i;
+    }
+
+    private:
+    // levels[0] has a bit per index
+    std::vector<std::vector<uint64_t>> levels;
+};
+
+// Min queue of (key, item) pairs with keys in [min_key, max_key], each item
+// is at most once in the queue. The keys are quantized to buckets of equal
+// width, the lowest non-empty bucket is found by the bitmap and the exact
+// minimum by scanning the bucket, so the extracted keys don't have to be
+// monotone as in a radix heap. It is fast when the keys are spread over the
+// buckets, a bucket with many items makes the scans slow. The buckets are
+// intrusive lists over the items, so nothing is allocated after
+// construction.
+class BucketQueue {
+    public:
+    using Item = uint32_t;
+
+    BucketQueue(size_t capacity, double min_key, double max_key, size_t buckets)
+        : min_key(min_key)
+        , scale(max_key > min_key ? buckets / (max_key - min_key) : 0)
+        , keys(capacity)
+        , bucket_of(capacity, npos)
+        , next(capacity)
+        , prev(capacity)
+        , heads(buckets, npos)
+        , non_empty(buckets)
+        , count(0)
+    { }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    bool contains(Item item) const {
+        return bucket_of[item] != npos;
+    }
+
+    // inserts the item or lowers its key, a larger key is ignored
+    void push_or_decrease(Item item, double key) {
+        auto b = bucket_index(key);
+        if (bucket_of[item] != npos) {
+            if (!(key < keys[item])) {
+                return;
+            }
+            keys[item] = key;
+            if (bucket_of[item] == b) {
+                return;
+            }
+            remove(item);
+        }
+        keys[item] = key;
+        insert(item, b);
+    }
+
+    std::pair<double, Item> pop() {
+        auto min_item = heads[non_empty.first()];
+        for (auto item = next[min_item]; item != npos; item = next[item]) {
+            if (keys[item] < keys[min_item]) {
+                min_item = item;
+            }
+        }
+        remove(min_item);
+        return {keys[min_item], min_item};
+    }
+
+    private:
+    static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+    double min_key;
+    double scale;
+    std::vector<double> keys;
+    std::vector<uint32_t> bucket_of;
+    std::vector<Item> next;
+    std::vector<Item> prev;
+    std::vector<Item> heads;
+    HierarchicalBitmap non_empty;
+    size_t count;
+
+    uint32_t bucket_index(double key) const {
+        if (!(key > min_key)) {
+            return 0;
+        }
+        auto b = static_cast<size_t>((key - min_key) * scale);
+        return std::min(b, heads.size() - 1);
+    }
+
+    void insert(Item item, uint32_t b) {
+        bucket_of[item] = b;
+        prev[item] = npos;
+        next[item] = heads[b];
+        if (heads[b] == npos) {
+            non_empty.set(b);
+        } else {
+            prev[heads[b]] = item;
+        }
+        heads[b] = item;
+        count++;
+    }
+
+    void remove(Item item) {
+        auto b = bucket_of[item];
+        if (prev[item] == npos) {
+            heads[b] = next[item];
+            if (heads[b] == npos) {
+                non_empty.reset(b);
+            }
+        } else {
+            next[prev[item]] = next[item];
+        }
+        if (next[item] != npos) {
+            prev[next[item]] = prev[item];
+        }
+        bucket_of[item] = npos;
+        count--;
+    }
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <vector>
+
+// compact indexes used by the flat graph, graphs with more than 2^32
+// vertexes or edges are not supported
+using VertexId = uint32_t;
+using EdgeId = uint32_t;
+
+constexpr EdgeId NoEdge = std::numeric_limits<EdgeId>::max();
+
+// Undirected weighted graph in compressed sparse row format.
+// Each edge is stored once in the edge arrays (indexed by EdgeId) and the
+// adjacency of each vertex only references it by id, so the adjacency scans
+// are sequential and the weights are in one contiguous array.
+// The arrays are read only views, so they can point directly into a mapped
+// binary graph file.
+struct CSRGraph {
+    size_t vertexes = 0;
+    // the adjacency of u is in [offsets[u], offsets[u + 1])
+    std::span<const uint64_t> offsets;
+    std::span<const VertexId> neighbors;
+    std::span<const EdgeId> edge_ids;
+    // endpoints and weights of the edges
+    std::span<const VertexId> sources;
+    std::span<const VertexId> targets;
+    std::span<const double> weights;
+    // keeps the memory of the views alive
+    std::shared_ptr<const void> storage;
+
+    size_t num_vertices() const {
+        return vertexes;
+    }
+
+    size_t num_edges() const {
+        return weights.size();
+    }
+
+    size_t degree(size_t u) const {
+        return offsets[u + 1] - offsets[u];
+    }
+
+    VertexId other(EdgeId e, VertexId u) const {
+        return sources[e] == u ? targets[e] : sources[e];
+    }
+
+    // total order on the edges, ties in weight are broken by the id
+    bool lighter(EdgeId a, EdgeId b) const {
+        return weights[a] < weights[b] || (weights[a] == weights[b] && a < b);
+    }
+
+    // NoEdge if u and v are not adjacent
+    EdgeId find_edge(size_t u, size_t v) const {
+        for (size_t i = offsets[u]; i < offsets[u + 1]; i++) {
+            if (neighbors[i] == v) {
+                return edge_ids[i];
+            }
+        }
+        return NoEdge;
+    }
+};
+
+// builds the adjacency arrays, the edge ids are the indexes into the given
+// edge arrays, the input must not contain multiedges
+CSRGraph build_csr(size_t vertexes, std::vector<VertexId> sources,
+        std::vector<VertexId> targets, std::vector<double> weights);
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Min heap of (key, item) pairs with D children per node, items are indexes
+// smaller than the capacity and each is at most once in the heap, so
+// decrease key finds it by the position array. The entries are stored
+// contiguously, larger D makes the heap shallower and the children of a
+// node share cache lines.
+template<size_t D, typename Key>
+class IndexedDaryHeap {
+    static_assert(D >= 2);
+
+    public:
+    using Item = uint32_t;
+
+    IndexedDaryHeap(size_t capacity) : pos(capacity, npos) {
+        heap.reserve(capacity);
+    }
+
+    bool empty() const {
+        return heap.empty();
+    }
+
+    size_t size() const {
+        return heap.size();
+    }
+
+    bool contains(Item item) const {
+        return pos[item] != npos;
+    }
+
+    std::pair<Key, Item> const& top() const {
+        return heap.front();
+    }
+
+    // inserts the item or lowers its key, a larger key is ignored
+    void push_or_decrease(Item item, Key key) {
+        if (pos[item] == npos) {
+            heap.emplace_back(key, item);
+            sift_up(heap.size() - 1);
+        } else if (key < heap[pos[item]].first) {
+            heap[pos[item]].first = key;
+            sift_up(pos[item]);
+        }
+    }
+
+    void clear() {
+        for (auto& entry : heap) {
+            pos[entry.second] = npos;
+        }
+        heap.clear();
+    }
+
+    std::pair<Key, Item> pop() {
+        auto res = heap.front();
+        pos[res.second] = npos;
+        auto last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            sift_down(0, last);
+        }
+        return res;
+    }
+
+    private:
+    static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+    std::vector<std::pair<Key, Item>> heap;
+    std::vector<uint32_t> pos;
+
+    // the entry is moved only once to its final position
+    void sift_up(size_t i) {
+        auto entry = heap[i];
+        while (i > 0) {
+            size_t parent = (i - 1) / D;
+            if (!(entry.first < heap[parent].first)) {
+                break;
+            }
+            place(i, heap[parent]);
+            i = parent;
+        }
+        place(i, entry);
+    }
+
+    // places entry to the hole at i and moves it down
+    void sift_down(size_t i, std::pair<Key, Item> entry) {
+        size_t n = heap.size();
+        while (true) {
+            size_t first = D * i + 1;
+            if (first >= n) {
+                break;
+            }
+            size_t last = std::min(first + D, n);
+            size_t min_child = first;
+            for (size_t c = first + 1; c < last; c++) {
+                if (heap[c].first < heap[min_child].first) {
+                    min_child = c;
+                }
+            }
+            if (!(heap[min_child].first < entry.first)) {
+                break;
+            }
+            place(i, heap[min_child]);
+            i = min_child;
+        }
+        place(i, entry);
+    }
+
+    void place(size_t i, std::pair<Key, Item> entry) {
+        heap[i] = entry;
+        pos[entry.second] = i;
+    }
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "csr_graph.h"
+#include "link_cut_tree.h"
+
+#include <cstddef>
+#include <vector>
+
+// replacement of a tree edge made by an update, removed is NoEdge when the
+// added edge joined two trees
+struct MSTSwap {
+    EdgeId added;
+    EdgeId removed;
+};
+
+// Minimum spanning forest maintained under edge insertions and weight
+// decreases. The forest is kept in a link-cut tree where every tree edge is
+// a node between its endpoints, so a new edge (u, v) replaces the heaviest
+// edge on the tree path from u to v when it is lighter, in O(log n)
+// amortized per update. The edge ids of the initial graph are kept and the
+// inserted edges get the next ids. Equal weights are ordered by the id like
+// in CSRGraph::lighter.
+class DynamicMST {
+    public:
+    // mst has to be a minimum spanning forest of the graph, given by the ids
+    // of its edges
+    DynamicMST(CSRGraph const& graph, std::vector<EdgeId> const& mst);
+
+    // returns the id of the new edge
+    EdgeId insert_edge(VertexId u, VertexId v, double weight);
+    // throws std::invalid_argument when the weight increases, that can
+    // bring back an edge which was dropped
+    void decrease_weight(EdgeId e, double weight);
+
+    size_t num_vertices() const {
+        return vertexes;
+    }
+
+    size_t num_edges() const {
+        return weights.size();
+    }
+
+    double weight(EdgeId e) const {
+        return weights[e];
+    }
+
+    bool in_tree(EdgeId e) const {
+        return tree[e];
+    }
+
+    double total_weight() const {
+        return tree_weight;
+    }
+
+    std::vector<EdgeId> tree_edges() const;
+
+    // every change of the forest since the construction in order
+    std::vector<MSTSwap> const& swaps() const {
+        return swap_log;
+    }
+
+    private:
+    size_t vertexes;
+    std::vector<VertexId> sources;
+    std::vector<VertexId> targets;
+    std::vector<double> weights;
+    std::vector<bool> tree;
+    LinkCutTree forest;
+    double tree_weight;
+    std::vector<MSTSwap> swap_log;
+
+    LinkCutTree::Node node(EdgeId e) const {
+        return vertexes + e;
+    }
+
+    void link(EdgeId e);
+    void cut(EdgeId e);
+    // adds e to the forest if it is lighter than the heaviest edge on the
+    // path between its endpoints
+    void offer(EdgeId e);
+};
@@ -1,14 +1,18 @@
 #pragma once
 
+#include "csr_graph.h"
+#include "graph_io.h"
 #include "utils.h"
 
 #include <algorithm>
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/graph_traits.hpp>
 #include <filesystem>
+#include <memory>
+#include <optional>
 #include <ostream>
 #include <string>
-#include <unordered_set>
+#include <tuple>
 #include <variant>
 #include <vector>
 
@@ -26,25 +30,42 @@ using Edge = boost::graph_traits<GraphType>::edge_descriptor;
 using Vertex = boost::graph_traits<GraphType>::vertex_descriptor;
 
 struct Graph {
-    GraphType graph;
-    boost::property_map<GraphType, boost::edge_weight_t>::type weight_map;
+    // flat representation used by the algorithms
+    CSRGraph csr;
+    // properties of the graph which are already known, binary graph files
+    // store them in the header
+    std::optional<bool> connected;
+    std::optional<bool> unique_weights;
 
-    Graph(size_t vertexes) : graph(vertexes), weight_map(get(boost::edge_weight, graph)) { }
+    Graph(CSRGraph csr) : csr(std::move(csr)), connected(), unique_weights(), adjacency() { }
+
+    // adjacency_list copy of the graph, it is built on first use because only
+    // the boost reference implementations need it, the edges are added in the
+    // order of their ids
+    GraphType& graph();
+    boost::property_map<GraphType, boost::edge_weight_t>::type weight_map() {
+        return get(boost::edge_weight, graph());
+    }
 
     bool is_connected();
+    bool has_unique_weights();
 
     // for testing of implementations
     double mst_weight();
-};
 
-inline std::pair<Vertex, Vertex> ordered(Vertex u, Vertex v) {
-    return {std::min(u, v), std::max(u, v)};
-}
+    private:
+    std::unique_ptr<GraphType> adjacency;
+};
 
-Graph parse_graph(std::filesystem::path file);
+// edge ids are the indexes into edges
+Graph build_graph(EdgeList edges);
+// reads both the text and the binary format
+Graph parse_graph(std::filesystem::path file, size_t threads = default_thread_count());
 void dump_as_dot(std::ostream& os, GraphType const& graph);
+// (u, v, weight) of the edges in the order of boost::edges
+std::vector<std::tuple<Vertex, Vertex, double>> weighted_edges(GraphType const& graph);
 
-bool all_edge_weights_unique(GraphType const& g);
+bool all_edge_weights_unique(CSRGraph const& g);
 std::vector<Vertex> find_path(const GraphType& g, Vertex start, Vertex end);
 
 // slow, only for testing
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "csr_graph.h"
+#include "parallel.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// read only memory mapping of a whole file
+class MappedFile {
+    public:
+    MappedFile(std::filesystem::path file);
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+    ~MappedFile();
+
+    const char* data() const {
+        return ptr;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+    std::string_view view() const {
+        return {ptr, length};
+    }
+
+    private:
+    const char* ptr;
+    size_t length;
+};
+
+// the edges of a graph as parallel arrays
+struct EdgeList {
+    size_t vertexes = 0;
+    std::vector<VertexId> sources;
+    std::vector<VertexId> targets;
+    std::vector<double> weights;
+    // time of each edge of a stream, empty for graphs
+    std::vector<double> timestamps;
+
+    size_t size() const {
+        return weights.size();
+    }
+};
+
+// parses the "n m / u v w" text format, the body is split into chunks
+// which are parsed in parallel
+EdgeList load_edge_list(std::filesystem::path file, size_t threads = default_thread_count());
+// parses an edge stream, the "n m" header and "u v w t" lines with the time
+// t of the edge, the edges stay in the file order
+EdgeList load_edge_stream(std::filesystem::path file, size_t threads = default_thread_count());
+
+// "u v w" lines without the header, for the updates of a graph with the
+// given number of vertexes, lines which are not "u v w" are skipped
+EdgeList load_edge_updates(std::filesystem::path file, size_t vertexes);
+
+// removes multiedges, (u, v) and (v, u) are the same edge, the first
+// occurrence is kept and the order of the kept edges is preserved
+void remove_multiedges(EdgeList& edges);
+
+// the edges of a tree as "u v" lines, more numbers on a line (like the
+// weight) are ignored and lines which don't start with two numbers skipped
+std::vector<std::pair<VertexId, VertexId>> load_tree_edges(std::filesystem::path file);
+// the parent of every vertex as one number per line, the roots are their own
+// parents, returns the (vertex, parent) edges
+std::vector<std::pair<VertexId, VertexId>> load_predecessor_map(std::filesystem::path file);
+
+// Binary graph format, version 1. All values are in native byte order and
+// every array starts 8 byte aligned, so the file can be mapped and used
+// without parsing:
+//   BinaryGraphHeader
+//   weights   double[edges]
+//   offsets   uint64[vertexes + 1]
+//   sources   uint32[edges]
+//   targets   uint32[edges]
+//   neighbors uint32[2 * edges]
+//   edge_ids  uint32[2 * edges]
+// The writer always computes the properties, so a missing flag means that
+// the property does not hold. Graphs without BinaryGraphDeduplicated get
+// their multiedges removed by parse_graph.
+constexpr char BinaryGraphMagic[8] = {'M', 'S', 'T', 'G', 'R', 'A', 'P', 'H'};
+constexpr uint32_t BinaryGraphVersion = 1;
+
+enum BinaryGraphFlags : uint32_t {
+    BinaryGraphDeduplicated = 1u << 0,
+    BinaryGraphUniqueWeights = 1u << 1,
+    BinaryGraphConnected = 1u << 2,
+};
+
+struct BinaryGraphHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t vertexes;
+    uint64_t edges;
+};
+
+bool is_binary_graph(std::filesystem::path file);
+void write_binary_graph(std::filesystem::path file, CSRGraph const& graph, uint32_t flags);
+// the arrays of the returned graph point into the mapped file, they are
+// checked to be consistent and a corrupted file throws
+CSRGraph open_binary_graph(std::filesystem::path file, uint32_t& flags);
@@ -4,48 +4,80 @@
 #pragma once
 
 #include "graph.h"
+#include "rooted_tree.h"
+#include <cstdint>
+#include <memory_resource>
+#include <span>
 #include <string>
+#include <utility>
 
+// the tables are allocated from the resource of the tree
 class LCA {
     public:
-    GraphType& graph;
+    RootedTree tree;
     size_t root;
     size_t edges;
     size_t euler_size;
     size_t block_size;
     size_t block_cnt;
-    // the order of vertexes in euler tour and their heights
-    std::vector<Vertex> euler_tour;
-    std::vector<size_t> height;
+    // the order of vertexes in euler tour and their heights, the tour is
+    // shorter than 2^32 so its positions and the heights fit to 32 bits
+    std::pmr::vector<Vertex> euler_tour;
+    std::pmr::vector<uint32_t> height;
     // the index in euler_tour of first occurence of vertex
-    std::vector<size_t> first_visit;
-    std::vector<std::vector<size_t>> sparse_table;
-    std::vector<size_t> block_mask;
-    // TODO allocate as continuous memory and remove redundant fields
-    // the sizes of the last vector decrease with the index of the second field
-    // current impl still takes up that space
-    // WARN the meaning of the last index would have to change to length instead of end of interval
-    std::vector<std::vector<std::vector<size_t>>> blocks;
-    
+    std::pmr::vector<uint32_t> first_visit;
+    // height of each vertex in euler_tour, so comparing positions of the tour
+    // doesn't go through euler_tour to height
+    std::pmr::vector<uint32_t> euler_height;
+    // the position of the min of 2^k blocks starting at block i is at
+    // sparse_table[sparse_offset[k] + i], only the blocks for which the
+    // interval fits are stored
+    std::pmr::vector<uint32_t> sparse_table;
+    std::pmr::vector<size_t> sparse_offset;
+    // bit i set if the height goes up between positions i and i + 1 of block
+    std::pmr::vector<uint32_t> block_mask;
+    // the in block position of the min of [l, r] for every mask, the rows
+    // l of a mask are stored one after another with only the r >= l part,
+    // the block size is at most 32 so the positions fit to a byte
+    std::pmr::vector<uint8_t> blocks;
+    size_t mask_stride;
 
 
-    LCA(GraphType& graph, Vertex root);
+
+    // without the tables only the tour, heights and parents are built, for
+    // users which answer their lca queries offline
+    LCA(RootedTree tree, bool build_tables = true);
+    // the root is given by the tree, this catches the root converted to bool
+    LCA(RootedTree tree, Vertex root, bool build_tables = true) = delete;
+    LCA(GraphType const& graph, Vertex root, bool build_tables = true)
+        : LCA(rooted_tree(graph, root), build_tables)
+    { }
 
     void build_euler_tour();
     void build_sparse_table();
     void build_rmq();
 
     size_t lca(size_t u, size_t v);
+    // the lca of each pair, the queries are answered sorted by the block of
+    // their left end, so the block and sparse table lookups of consecutive
+    // queries are close to each other
+    std::pmr::vector<Vertex> lca_many(std::span<std::pair<Vertex, Vertex> const> queries);
     size_t lca_in_block(size_t block_index, size_t in_block_index, size_t interval_length);
 
+    std::pmr::memory_resource* resource() const {
+        return tree.resource();
+    }
+
     size_t min_by_height(size_t a, size_t b) const {
-        return height[euler_tour[a]] < height[euler_tour[b]] ? a : b;
+        return euler_height[a] < euler_height[b] ? a : b;
     }
     size_t depth(Vertex u) {
         return height[u];
     }
 
-    Vertex parrent(Vertex u);
+    Vertex parrent(Vertex u) const {
+        return tree.parent[u];
+    }
 
 
     // for testing
@@ -61,5 +93,13 @@ class LCA {
     std::string dump_blocks();
     std::string dump_block(size_t block_index);
     std::string dump_sparse_table();
-};
 
+    private:
+    // lca of positions l <= r of the euler tour
+    size_t lca_of_positions(size_t l, size_t r);
+
+    // index of [l, r] in the triangle of a mask
+    size_t triangle_index(size_t l, size_t r) const {
+        return l * block_size - l * (l - 1) / 2 + (r - l);
+    }
+};
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Forest of weighted nodes which supports linking and cutting of trees and
+// the heaviest node on the path between two nodes in O(log n) amortized.
+// Every preferred path is a splay tree ordered by depth, which keeps the
+// heaviest node of its subtree. Rerooting reverses a path by a lazy flag.
+// Edges with weights are represented by nodes between their endpoints, the
+// heavier of two nodes with equal weight is the one with larger index. The
+// nodes are flat arrays indexed by Node.
+class LinkCutTree {
+    public:
+    using Node = uint32_t;
+    static constexpr Node none = std::numeric_limits<Node>::max();
+
+    LinkCutTree(size_t nodes = 0, double weight = -std::numeric_limits<double>::infinity()) {
+        for (size_t i = 0; i < nodes; i++) {
+            add_node(weight);
+        }
+    }
+
+    size_t size() const {
+        return weight.size();
+    }
+
+    Node add_node(double w) {
+        Node u = weight.size();
+        child.push_back({none, none});
+        parent.push_back(none);
+        flip.push_back(false);
+        weight.push_back(w);
+        heaviest.push_back(u);
+        return u;
+    }
+
+    double weight_of(Node u) const {
+        return weight[u];
+    }
+
+    void set_weight(Node u, double w) {
+        access(u);
+        weight[u] = w;
+        update(u);
+    }
+
+    bool connected(Node u, Node v) {
+        return u == v || find_root(u) == find_root(v);
+    }
+
+    // u and v have to be in different trees
+    void link(Node u, Node v) {
+        make_root(u);
+        parent[u] = v;
+    }
+
+    // u and v have to be adjacent
+    void cut(Node u, Node v) {
+        make_root(u);
+        access(v);
+        // the path is u, v so u is the left child of v
+        child[v][0] = none;
+        parent[u] = none;
+        update(v);
+    }
+
+    // the heaviest node on the path between u and v, including them, none if
+    // they are in different trees
+    Node path_max(Node u, Node v) {
+        make_root(u);
+        if (find_root(v) != u) {
+            return none;
+        }
+        access(v);
+        return heaviest[v];
+    }
+
+    private:
+    std::vector<std::array<Node, 2>> child;
+    // the parent in the splay tree, or the path parent for the splay root
+    std::vector<Node> parent;
+    std::vector<bool> flip;
+    std::vector<double> weight;
+    std::vector<Node> heaviest;
+    std::vector<Node> splay_path;
+
+    bool heavier(Node a, Node b) const {
+        return weight[a] > weight[b] || (weight[a] == weight[b] && a > b);
+    }
+
+    bool is_splay_root(Node u) const {
+        auto p = parent[u];
+        return p == none || (child[p][0] != u && child[p][1] != u);
+    }
+
+    void push(Node u) {
+        if (flip[u]) {
+            std::swap(child[u][0], child[u][1]);
+            for (auto c : child[u]) {
+                if (c != none) {
+                    flip[c] = !flip[c];
+                }
+            }
+            flip[u] = false;
+        }
+    }
+
+    void update(Node u) {
+        heaviest[u] = u;
+        for (auto c : child[u]) {
+            if (c != none && heavier(heaviest[c], heaviest[u])) {
+                heaviest[u] = heaviest[c];
+            }
+        }
+    }
+
+    void rotate(Node u) {
+        auto p = parent[u];
+        auto g = parent[p];
+        bool right = child[p][1] == u;
+        if (!is_splay_root(p)) {
+            child[g][child[g][1] == p] = u;
+        }
+        parent[u] = g;
+        child[p][right] = child[u][!right];
+        if (child[p][right] != none) {
+            parent[child[p][right]] = p;
+        }
+        child[u][!right] = p;
+        parent[p] = u;
+        update(p);
+        update(u);
+    }
+
+    void splay(Node u) {
+        // the flags are pushed from the splay root down before rotating
+        splay_path.clear();
+        for (auto v = u; ; v = parent[v]) {
+            splay_path.push_back(v);
+            if (is_splay_root(v)) {
+                break;
+            }
+        }
+        for (auto it = splay_path.rbegin(); it != splay_path.rend(); it++) {
+            push(*it);
+        }
+        while (!is_splay_root(u)) {
+            auto p = parent[u];
+            if (!is_splay_root(p)) {
+                auto g = parent[p];
+                bool zig_zig = (child[g][0] == p) == (child[p][0] == u);
+                rotate(zig_zig ? p : u);
+            }
+            rotate(u);
+        }
+    }
+
+    // makes the path from the root to u preferred, u becomes the root of its
+    // splay tree with no right child
+    void access(Node u) {
+        auto last = none;
+        for (auto v = u; v != none; v = parent[v]) {
+            splay(v);
+            child[v][1] = last;
+            update(v);
+            last = v;
+        }
+        splay(u);
+    }
+
+    void make_root(Node u) {
+        access(u);
+        flip[u] = !flip[u];
+    }
+
+    Node find_root(Node u) {
+        access(u);
+        push(u);
+        while (child[u][0] != none) {
+            u = child[u][0];
+            push(u);
+        }
+        splay(u);
+        return u;
+    }
+};
@@ -2,23 +2,27 @@
 
 #include "boost/graph/kruskal_min_spanning_tree.hpp"
 #include "boost/graph/prim_minimum_spanning_tree.hpp"
+#include "arena.h"
 #include "graph.h"
 #include "utils.h"
 
 #include <algorithm>
+#include <functional>
 #include <boost/graph/detail/adjacency_list.hpp>
 #include <boost/graph/subgraph.hpp>
-#include <boost/pending/disjoint_sets.hpp>
 #include <boost/range/iterator_range_core.hpp>
 #include <limits>
 #include <memory>
+#include <memory_resource>
 #include <optional>
+#include <random>
 #include <tuple>
 #include <unordered_map>
 #include <utility>
 
 using PredecessorMap = std::vector<Vertex>;
-using MST = std::variant<std::vector<Edge>, std::vector<std::pair<Vertex, Vertex>>, PredecessorMap>;
+// std::vector<EdgeId> are ids into the csr of the graph
+using MST = std::variant<std::vector<EdgeId>, std::vector<Edge>, std::vector<std::pair<Vertex, Vertex>>, PredecessorMap>;
 
 class MSTAlgorithm {
     public:
@@ -30,6 +34,12 @@ class MSTAlgorithm {
     virtual MST compute_mst() = 0;
 
     double mst_weight(MST mst);
+    // the csr ids of the edges of any mst representation
+    std::vector<EdgeId> mst_edge_ids(MST mst);
+    // (name, json value) of the algorithm specific statistics of the runs
+    virtual std::vector<std::pair<std::string, std::string>> stats() {
+        return {};
+    }
     virtual ~MSTAlgorithm() = default;
 };
 
@@ -41,6 +51,24 @@ class Kruskal : public MSTAlgorithm {
     MST compute_mst() override;
 };
 
+// sorts the edges by LSD radix sort on the bits of the weights
+class KruskalRadix : public MSTAlgorithm {
+    public:
+    KruskalRadix(Graph& g) : MSTAlgorithm(g, "kruskal_radix") { }
+
+    MST compute_mst() override;
+};
+
+// Kruskal which partitions the edges around a pivot weight like quicksort,
+// the heavy half is filtered by the union find before it is processed, so
+// the edges which are never needed don't have to be sorted
+class FilterKruskal : public MSTAlgorithm {
+    public:
+    FilterKruskal(Graph& g) : MSTAlgorithm(g, "filter_kruskal") { }
+
+    MST compute_mst() override;
+};
+
 // for comparing with boost impl to test quality of our implementation
 class KruskalBoost : public MSTAlgorithm {
     public:
@@ -48,25 +76,74 @@ class KruskalBoost : public MSTAlgorithm {
 
     MST compute_mst() override {
         auto mst = std::vector<Edge>{};
-        boost::kruskal_minimum_spanning_tree(g.graph, std::back_inserter(mst));
+        boost::kruskal_minimum_spanning_tree(g.graph(), std::back_inserter(mst));
         return mst;
     }
 };
 
+// edge list of one level of the KKT recursion, the ids point to the edges
+// of the input graph, so the weights are looked up in its csr, the edges
+// are always kept in the order of their ids, the graphs derived from it are
+// allocated from the same resource
+struct KKTGraph {
+    size_t vertexes = 0;
+    std::pmr::vector<VertexId> sources;
+    std::pmr::vector<VertexId> targets;
+    std::pmr::vector<EdgeId> ids;
+
+    explicit KKTGraph(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : sources(resource), targets(resource), ids(resource) { }
+
+    std::pmr::memory_resource* resource() const {
+        return ids.get_allocator().resource();
+    }
+
+    size_t num_edges() const {
+        return ids.size();
+    }
+};
+
 class RandomKKT : public MSTAlgorithm {
     public:
-    // We abuse here the fact that the edge weights are unique, to map
-    // the edges in the subgraphs to the original graph.
-    // If the edges were not unique we could instead assing each edge id
-    // and keep it as edge property in each subgraph, and order dedges by it,
-    // but that would make the code even more complicated, so we do this
-    // instead.
-    std::unordered_map<double, Edge> weight_to_edge;
+    std::mt19937 gen;
 
     RandomKKT(Graph &g);
 
     MST compute_mst() override;
-    std::unordered_set<double> compute_mst_impl(GraphType& graph);
+    // adds the ids of the msf edges of graph to mst
+    void compute_mst_impl(KKTGraph const& graph, std::pmr::vector<EdgeId>& mst);
+
+    protected:
+    RandomKKT(Graph &g, std::string name);
+
+    // the graphs of all levels of the recursion are allocated from it
+    std::pmr::memory_resource* resource;
+    // the verification of one level is allocated from it, nothing of it
+    // outlives the level
+    std::pmr::memory_resource* scratch;
+
+    // called after the verification of each level
+    virtual void release_scratch() { }
+};
+
+// RandomKKT which takes all its buffers from two monotonic arenas, one for
+// the graphs of the recursion released after each run and one for the
+// verification of a level released after the level. They are sized from
+// the input graph, so the levels don't go through malloc at all, and
+// together they are the whole footprint of a run.
+class RandomKKTArena : public RandomKKT {
+    public:
+    RandomKKTArena(Graph &g);
+
+    MST compute_mst() override;
+    std::vector<std::pair<std::string, std::string>> stats() override;
+
+    protected:
+    void release_scratch() override;
+
+    private:
+    Arena arena;
+    Arena scratch_arena;
 };
 
 class PrimBinHeap : public MSTAlgorithm {
@@ -83,14 +160,47 @@ class PrimFibHeap : public MSTAlgorithm {
     MST compute_mst() override;
 };
 
+// Prim with indexed D-ary heap, the heap has each vertex at most once and
+// lowers its key in place, so it never has more than n entries
+template<size_t D>
+class PrimDaryHeap : public MSTAlgorithm {
+    public:
+    PrimDaryHeap(Graph &g) : MSTAlgorithm(g, "prim_dary_heap_" + std::to_string(D)) { }
+
+    MST compute_mst() override;
+};
+
+extern template class PrimDaryHeap<2>;
+extern template class PrimDaryHeap<4>;
+extern template class PrimDaryHeap<8>;
+
+// Prim with bucket queue over the weight range of the graph, the range and
+// the distribution of the weights are checked on construction, when some
+// bucket would get too many edges it falls back to the 4-ary heap
+class PrimBucketQueue : public MSTAlgorithm {
+    public:
+    PrimBucketQueue(Graph &g);
+
+    MST compute_mst() override;
+    std::vector<std::pair<std::string, std::string>> stats() override {
+        return {{"bucket_fallback", bool_to_str(fallback)}};
+    }
+
+    private:
+    double min_weight;
+    double max_weight;
+    size_t buckets;
+    bool fallback;
+};
+
 // for comparing with boost impl to test quality of our implementation
 class PrimBoost : public MSTAlgorithm {
     public:
     PrimBoost(Graph &g) : MSTAlgorithm(g, "prim_boost") { }
 
     MST compute_mst() override {
-        auto preds = std::vector<Vertex>(boost::num_vertices(g.graph));
-        boost::prim_minimum_spanning_tree(g.graph, preds.data());
+        auto preds = std::vector<Vertex>(boost::num_vertices(g.graph()));
+        boost::prim_minimum_spanning_tree(g.graph(), preds.data());
         return preds;
     }
 };
@@ -103,25 +213,80 @@ class Boruvka : public MSTAlgorithm {
     MST compute_mst() override;
 };
 
-using EdgeMap = std::unordered_map<std::pair<Vertex, Vertex>, std::pair<Vertex, Vertex>, PairHash<Vertex, Vertex>>;
-using EdgeSet = std::unordered_set<std::pair<Vertex, Vertex>, PairHash<Vertex, Vertex>>;
-std::tuple<EdgeSet, GraphType, EdgeMap>
-borůvka_step(GraphType& graph, std::optional<EdgeMap> cur_to_old);
-std::tuple<GraphType, std::unordered_set<double>> borůvka_step2 (GraphType& graph);
-// edges are the form vec<(node_in_fbt, node_in_reduced, weigth)>
-std::tuple<GraphType, std::vector<std::tuple<Vertex, Vertex, double>>> boruvka_step_fbt(GraphType& graph);
+// Borůvka over flat edge arrays where every phase of a round is split
+// between the threads, the min edge of each component is found with CAS on
+// the edge position and the components are merged by lock free union find
+class ParallelBoruvka : public MSTAlgorithm {
+    public:
+    size_t threads;
+
+    ParallelBoruvka(Graph &g, size_t threads)
+        : MSTAlgorithm(g, "parallel_boruvka")
+        , threads(std::max<size_t>(1, threads))
+    { }
+
+    MST compute_mst() override;
+};
+
+// Vertexes are split into a partition per thread and each thread grows
+// Prim trees in its partition until the lightest leaving edge leads out of
+// it, the trees are contracted and the rest of the mst is found by Kruskal
+// on the edges between them
+class PrimKruskalHybrid : public MSTAlgorithm {
+    public:
+    size_t threads;
+
+    PrimKruskalHybrid(Graph &g, size_t threads) : MSTAlgorithm(g, "prim_kruskal_hybrid"), threads(threads) { }
+
+    MST compute_mst() override;
+};
+
+// ties in weights are broken by the edge ids, the returned graph only has
+// the vertexes which still have some edge
+std::tuple<KKTGraph, std::pmr::vector<EdgeId>> borůvka_step2(KKTGraph const& graph, CSRGraph const& csr);
+// adjacency_list copy of build_fbt of the tree, with the leaf of each tree
+// vertex and the root
 std::tuple<GraphType, std::vector<Vertex>, Vertex> st_to_fbt(GraphType& graph);
-GraphType remove_heavy_edges(GraphType& graph, std::unordered_set<double> forest_edges);
-GraphType remove_random_edges(GraphType& graph);
+// forest_edges are the ids of the edges of a forest in graph, the
+// verification is allocated from scratch and the result from the resource
+// of graph
+KKTGraph remove_heavy_edges(KKTGraph const& graph, std::pmr::vector<EdgeId> forest_edges, CSRGraph const& csr,
+        std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
+KKTGraph remove_random_edges(KKTGraph const& graph, std::mt19937& gen);
+
+// constructs the algorithm for the graph, so its setup can be measured
+using AlgorithmFactory = std::function<std::shared_ptr<MSTAlgorithm>(Graph&)>;
+
+template<typename Alg>
+std::pair<std::string, AlgorithmFactory> factory(std::string name) {
+    return {name, [](Graph& g) { return std::make_shared<Alg>(g); }};
+}
 
-inline std::vector<std::shared_ptr<MSTAlgorithm>> get_algorithms(Graph& g) {
+inline std::vector<std::pair<std::string, AlgorithmFactory>> get_algorithm_factories(size_t threads = default_thread_count()) {
+    std::vector<std::pair<std::string, AlgorithmFactory>> factories{};
+    factories.push_back(factory<Kruskal>("kruskal"));
+    factories.push_back(factory<KruskalRadix>("kruskal_radix"));
+    factories.push_back(factory<FilterKruskal>("filter_kruskal"));
+    factories.push_back(factory<KruskalBoost>("kruskal_boost"));
+    factories.push_back(factory<Boruvka>("boruvka"));
+    factories.push_back({"parallel_boruvka", [threads](Graph& g) { return std::make_shared<ParallelBoruvka>(g, threads); }});
+    factories.push_back({"prim_kruskal_hybrid", [threads](Graph& g) { return std::make_shared<PrimKruskalHybrid>(g, threads); }});
+    factories.push_back(factory<PrimBinHeap>("prim_bin_heap"));
+    factories.push_back(factory<PrimFibHeap>("prim_fib_heap"));
+    factories.push_back(factory<PrimDaryHeap<2>>("prim_dary_heap_2"));
+    factories.push_back(factory<PrimDaryHeap<4>>("prim_dary_heap_4"));
+    factories.push_back(factory<PrimDaryHeap<8>>("prim_dary_heap_8"));
+    factories.push_back(factory<PrimBucketQueue>("prim_bucket_queue"));
+    factories.push_back(factory<PrimBoost>("prim_boost"));
+    factories.push_back(factory<RandomKKT>("random_KKT"));
+    factories.push_back(factory<RandomKKTArena>("random_KKT_arena"));
+    return factories;
+}
+
+inline std::vector<std::shared_ptr<MSTAlgorithm>> get_algorithms(Graph& g, size_t threads = default_thread_count()) {
     std::vector<std::shared_ptr<MSTAlgorithm>> algs{};
-    algs.push_back(std::make_shared<Kruskal>(g));
-    algs.push_back(std::make_shared<KruskalBoost>(g));
-    algs.push_back(std::make_shared<Boruvka>(g));
-    algs.push_back(std::make_shared<PrimBinHeap>(g));
-    algs.push_back(std::make_shared<PrimFibHeap>(g));
-    algs.push_back(std::make_shared<PrimBoost>(g));
-    algs.push_back(std::make_shared<RandomKKT>(g));
+    for (auto& [name, make] : get_algorithm_factories(threads)) {
+        algs.push_back(make(g));
+    }
     return algs;
 }
@@ -1,51 +1,135 @@
+#pragma once
+
 #include "mst_algorithms.h"
 #include "graph.h"
 #include "lca.h"
+#include "offline_lca.h"
+#include "rooted_tree.h"
 #include "tree_path_maxima.h"
 
+#include <memory_resource>
+#include <span>
+
+// how the lca of the verification queries is found, the queries are known
+// up front so offline tarjan lca doesn't have to build the rmq tables
+enum class LCAMethod {
+    rmq,
+    offline,
+};
+
 struct MSTVerify {
-    GraphType span_tree;
-    GraphType fbt; // fully branching tree
+    // fully branching tree, its leafs are the vertexes of the spanning tree
+    RootedTree fbt;
     Vertex fbt_root;
     // (vertex in span_tree, vertex in spantree, weight on edge between them)
-    std::vector<std::tuple<Vertex, Vertex, double>> queries;
-    std::vector<Vertex> leaf_map;
-
-    MSTVerify(GraphType span_tree, std::vector<std::tuple<Vertex, Vertex, double>> queries)
-        : span_tree(span_tree)
-        , fbt_root()
-        , queries(queries)
-    {
-        auto [graph, map, root] = st_to_fbt(span_tree);
-        fbt = std::move(graph);
-        leaf_map = std::move(map);
-        fbt_root = root;
+    std::pmr::vector<std::tuple<Vertex, Vertex, double>> queries;
+    LCAMethod lca_method;
+
+    // the spanning tree on vertexes given by its (u, v, weight) edges, the
+    // fbt and the tables of the verification are allocated from the
+    // resource of queries
+    MSTVerify(size_t vertexes, std::span<std::tuple<Vertex, Vertex, double> const> tree_edges,
+            std::pmr::vector<std::tuple<Vertex, Vertex, double>> queries, LCAMethod lca_method = LCAMethod::rmq)
+        : fbt(build_fbt(vertexes, tree_edges, queries.get_allocator().resource()))
+        , fbt_root(fbt.root)
+        , queries(std::move(queries))
+        , lca_method(lca_method)
+    { }
+
+    MSTVerify(GraphType const& span_tree, std::vector<std::tuple<Vertex, Vertex, double>> const& queries,
+            LCAMethod lca_method = LCAMethod::rmq)
+        : MSTVerify(boost::num_vertices(span_tree), weighted_edges(span_tree),
+                std::pmr::vector<std::tuple<Vertex, Vertex, double>>(queries.begin(), queries.end()), lca_method)
+    { }
+
+    std::pmr::memory_resource* resource() const {
+        return fbt.resource();
+    }
+
+    // the max weight on the tree path between the endpoints of each query,
+    // the median tables are used for fbt up to max_median_depth deep
+    std::pmr::vector<double> path_maxima(size_t max_median_depth = median_table_max_depth) {
+        auto lca = LCA(fbt, lca_method == LCAMethod::rmq);
+        auto path_maxima_queries = transform_queries(lca);
+        auto res = std::pmr::vector<double>(queries.size(), resource());
+        auto collect = [&](auto&& tm) {
+            for (size_t i = 0; i < queries.size(); i++) {
+                auto a1 = tm.answers[2 * i];
+                auto a2 = tm.answers[2 * i + 1];
+                res[i] = std::max(tm.weight(a1), tm.weight(a2));
+            }
+        };
+        if (lca.max_depth() <= std::min(max_median_depth, median_table_max_depth)) {
+            collect(TreePathMaxima(path_maxima_queries, lca));
+        } else {
+            collect(TreePathMaximaWide(path_maxima_queries, lca));
+        }
+        return res;
     }
 
     std::unordered_set<double> compute_heavy_edges() {
-        auto lca = LCA(fbt, fbt_root);
         auto heavy_edges = std::unordered_set<double>{};
-        auto path_maxima_queries = transform_queries(lca);
-        auto tm = TreePathMaxima(path_maxima_queries, lca);
+        auto maxima = path_maxima();
         for (size_t i = 0; i < queries.size(); i++) {
-            auto a1 = tm.answers[2 * i];
-            auto a2 = tm.answers[2 * i + 1];
             auto weight = std::get<2>(queries[i]);
-            auto q_w = std::max(tm.weight(a1), tm.weight(a2));
-            heavy_edges.insert(std::max(weight, q_w));
+            heavy_edges.insert(std::max(weight, maxima[i]));
         }
 
         return heavy_edges;
     }
 
-    std::vector<BottomUpQuery> transform_queries(LCA& lca) {
-        auto tree_path_queries = std::vector<BottomUpQuery>{};
+    std::pmr::vector<BottomUpQuery> transform_queries(LCA& lca) {
+        auto endpoints = std::pmr::vector<std::pair<Vertex, Vertex>>(resource());
+        endpoints.reserve(queries.size());
         for (auto [u, v, weight] : queries) {
-            auto ancestor = lca.lca(u, v);
+            endpoints.emplace_back(u, v);
+        }
+        auto ancestors = lca_method == LCAMethod::rmq
+            ? lca.lca_many(endpoints)
+            : offline_lca(lca, endpoints);
+        auto tree_path_queries = std::pmr::vector<BottomUpQuery>(resource());
+        tree_path_queries.reserve(2 * queries.size());
+        for (size_t i = 0; i < queries.size(); i++) {
             // query i will be at (2i, 2i + 1)
-            tree_path_queries.push_back({u, ancestor});
-            tree_path_queries.push_back({v, ancestor});
+            tree_path_queries.push_back({endpoints[i].first, ancestors[i]});
+            tree_path_queries.push_back({endpoints[i].second, ancestors[i]});
         }
         return tree_path_queries;
     }
 };
+
+// the max weight on the forest path between the endpoints of each query, the
+// forest is given by its (u, v, weight) edges, queries with endpoints in
+// different trees get infinity and loops get -infinity. The result and all
+// the buffers are allocated from resource.
+std::pmr::vector<double> forest_path_maxima(size_t vertexes,
+        std::span<std::tuple<Vertex, Vertex, double> const> forest,
+        std::span<std::tuple<Vertex, Vertex, double> const> queries,
+        LCAMethod lca_method = LCAMethod::rmq,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+// result of checking a candidate tree given by its (u, v) edges against a graph
+struct MSTCertificate {
+    // tree edges which are not in the graph
+    std::vector<std::pair<VertexId, VertexId>> missing_edges;
+    // the first tree edge closing a cycle
+    EdgeId cycle_edge = NoEdge;
+    // some graph edge connects two trees of the forest
+    bool spanning = true;
+    double tree_weight = 0;
+    // the non-tree edges lighter than the max on the tree path between their
+    // endpoints, with the path max, only checked for spanning trees
+    std::vector<std::pair<EdgeId, double>> violations;
+
+    bool is_spanning_tree() const {
+        return missing_edges.empty() && cycle_edge == NoEdge && spanning;
+    }
+
+    bool is_minimal() const {
+        return is_spanning_tree() && violations.empty();
+    }
+};
+
+// a spanning forest of disconnected graph is accepted as spanning tree
+MSTCertificate verify_mst(CSRGraph const& csr, std::vector<std::pair<VertexId, VertexId>> const& tree,
+        LCAMethod lca_method = LCAMethod::rmq);
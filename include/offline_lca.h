@@ -0,0 +1,18 @@
+#pragma once
+
+#include "lca.h"
+
+#include <memory_resource>
+#include <span>
+#include <utility>
+#include <vector>
+
+// Tarjan's offline lca over the euler tour of LCA, which can be built
+// without its rmq tables. The tour steps from a vertex to its parent right
+// after the subtree of the vertex is finished, then the subtree is united
+// with the parent, so the lca of a finished vertex with the current one is
+// the parent which its set was last united to. Only the union find and the
+// queries of each vertex are needed, compared to the tables for online
+// queries.
+// the result and the buffers are allocated from the resource of tour
+std::pmr::vector<Vertex> offline_lca(LCA const& tour, std::span<std::pair<Vertex, Vertex> const> queries);
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+inline size_t default_thread_count() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// splits [0, n) into one contiguous range per thread and calls
+// fn(thread_index, begin, end) on each of them, the first range is
+// processed by the calling thread
+template<typename F>
+void parallel_for(size_t threads, size_t n, F fn) {
+    threads = std::max<size_t>(1, std::min(threads, n));
+    auto workers = std::vector<std::thread>{};
+    workers.reserve(threads - 1);
+    size_t step = n / threads;
+    size_t rest = n % threads;
+    size_t begin = 0;
+    size_t first_end = 0;
+    for (size_t t = 0; t < threads; t++) {
+        size_t end = begin + step + (t < rest ? 1 : 0);
+        if (t == 0) {
+            first_end = end;
+        } else {
+            workers.emplace_back(fn, t, begin, end);
+        }
+        begin = end;
+    }
+    fn(size_t{0}, size_t{0}, first_end);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
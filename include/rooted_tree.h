@@ -0,0 +1,60 @@
+#pragma once
+
+#include "graph.h"
+
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <tuple>
+#include <vector>
+
+// tree given by the parent of each vertex, with the children of each vertex
+// in one array, used instead of adjacency_list by LCA and TreePathMaxima.
+// The arrays are allocated from the resource of parent, copies stay in it.
+struct RootedTree {
+    Vertex root;
+    // null_vertex for the root
+    std::pmr::vector<Vertex> parent;
+    // weight of the edge to the parent, -inf for the root
+    std::pmr::vector<double> parent_weight;
+    std::pmr::vector<uint32_t> depth;
+    // the children of u are children[child_offset[u]] up to
+    // children[child_offset[u + 1]]
+    std::pmr::vector<uint32_t> child_offset;
+    std::pmr::vector<Vertex> children;
+
+    // builds the children and depths from the parents, the children of each
+    // vertex are in increasing order
+    RootedTree(Vertex root, std::pmr::vector<Vertex> parent, std::pmr::vector<double> parent_weight);
+    RootedTree(RootedTree const& other);
+    RootedTree(RootedTree&& other) = default;
+    RootedTree& operator=(RootedTree const& other) = default;
+    RootedTree& operator=(RootedTree&& other) = default;
+
+    std::pmr::memory_resource* resource() const {
+        return parent.get_allocator().resource();
+    }
+
+    size_t num_vertices() const {
+        return parent.size();
+    }
+
+    std::span<Vertex const> children_of(Vertex u) const {
+        return {children.data() + child_offset[u], children.data() + child_offset[u + 1]};
+    }
+};
+
+// the tree rooted at root, the children keep the order of the adjacency
+// lists
+RootedTree rooted_tree(GraphType const& tree, Vertex root);
+
+// The fully branching tree of the tree on vertexes given by its (u, v,
+// weight) edges, the tree must be connected. Every borůvka round adds a
+// vertex for each component, which becomes the parent of the components it
+// was merged from, with the weight of the lightest edge they had. The
+// leafs are the vertexes of the tree with the same numbers, the components
+// of a round are numbered by their smallest member and the root is the last
+// vertex. Contracting tree edges never creates parallel edges, so the
+// rounds just relabel the edge arrays, which at least halve every round.
+RootedTree build_fbt(size_t vertexes, std::span<std::tuple<Vertex, Vertex, double> const> edges,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource());
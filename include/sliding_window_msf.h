@@ -0,0 +1,85 @@
+#pragma once
+
+#include "csr_graph.h"
+#include "link_cut_tree.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Minimum spanning forest of a window of stream edges, the edges enter the
+// window as the newest and leave it as the oldest. An edge is added like in
+// DynamicMST, by replacing the heaviest edge on the tree path between its
+// endpoints in a link-cut tree, and every addition can be undone by
+// restoring the replaced edge. Removing the oldest edge is done by the
+// queue undo trick: the additions are kept on a stack where the edges which
+// leave first are marked as older, when the top isn't older the stack is
+// undone and reapplied so that the oldest edge gets on the top. Every edge
+// is reapplied O(log n) times amortized, so a window update costs
+// O(log^2 n) amortized. The forest only depends on the set of the edges,
+// equal weights are ordered by the slot of the edge.
+class SlidingWindowMSF {
+    public:
+    SlidingWindowMSF(size_t vertexes);
+
+    // adds the newest edge of the window
+    void push(VertexId u, VertexId v, double weight);
+    // removes the oldest edge of the window, which must not be empty
+    void pop();
+
+    size_t size() const {
+        return window.size();
+    }
+
+    bool empty() const {
+        return window.empty();
+    }
+
+    double total_weight() const {
+        return tree_weight;
+    }
+
+    size_t forest_size() const {
+        return tree_edges;
+    }
+
+    // slow, the weight of the forest computed from scratch by kruskal, for
+    // checking
+    double kruskal_weight() const;
+
+    private:
+    using Slot = uint32_t;
+    static constexpr Slot no_slot = LinkCutTree::none;
+
+    // an edge added to the forest and what it changed
+    struct Addition {
+        Slot edge;
+        bool older;
+        bool linked;
+        Slot replaced;
+    };
+
+    size_t vertexes;
+    // the edges are stored in slots which are reused after they leave
+    std::vector<VertexId> sources;
+    std::vector<VertexId> targets;
+    std::vector<double> weights;
+    std::vector<Slot> free_slots;
+    // the slots in the window from the oldest
+    std::deque<Slot> window;
+    std::vector<Addition> additions;
+    size_t older_count;
+    LinkCutTree forest;
+    double tree_weight;
+    size_t tree_edges;
+
+    LinkCutTree::Node node(Slot e) const {
+        return vertexes + e;
+    }
+
+    void link(Slot e);
+    void cut(Slot e);
+    void apply(Slot e, bool older);
+    Addition undo();
+};
@@ -7,6 +7,10 @@
 #include "graph.h"
 #include "lca.h"
 
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+
 // the query must be about leaf and its proper ancestor
 struct BottomUpQuery {
     Vertex leaf;
@@ -15,29 +19,39 @@ struct BottomUpQuery {
 
 constexpr size_t None = std::numeric_limits<size_t>::max();
 
+// deepest tree for TreePathMaxima, its median table has 2^(depth + 1)
+// entries, deeper trees go to TreePathMaximaWide
+constexpr size_t median_table_max_depth = 20;
+
+// medians of the sets of depths of a tree of the given depth, the entry of a
+// set S is its element with popcount(S) / 2 smaller elements. The tables
+// depend only on the depth, so they are built once per process, the small
+// ones at compile time, and shared by all instances and threads
+std::span<uint8_t const> cached_median_table(size_t depth);
+
 struct TreePathMaxima {
-    GraphType& tree; // must be a fully branching tree
+    RootedTree const& tree; // must be a fully branching tree
     Vertex root;
     size_t depth;
     LCA& lca;
-    std::vector<BottomUpQuery> queries;
+    std::pmr::vector<BottomUpQuery> queries;
     // leafs to queries
-    std::vector<size_t> first_query; // first query in leaf
-    std::vector<size_t> next_query; // links to the next query for the same leaf
+    std::pmr::vector<size_t> first_query; // first query in leaf
+    std::pmr::vector<size_t> next_query; // links to the next query for the same leaf
 
-    std::vector<size_t> query_sets;
-    std::vector<size_t> answer_sets;
+    std::pmr::vector<size_t> query_sets;
+    std::pmr::vector<size_t> answer_sets;
     // here will be the answer to each query, encoded as vertex whose edge
     // to parent is the maximal
-    std::vector<Vertex> answers;
+    std::pmr::vector<Vertex> answers;
 
-    std::vector<std::vector<Vertex>> rows; // rows of vetexes in each depth
-    std::vector<size_t> median_table; // precomputed medians
-    std::vector<size_t> T;
-    std::vector<size_t> visit_stack;
-    std::vector<double> weight_to_parent;
+    std::pmr::vector<std::pmr::vector<Vertex>> rows; // rows of vetexes in each depth
+    std::span<uint8_t const> median_table; // precomputed medians
+    std::pmr::vector<size_t> visit_stack;
+    std::pmr::vector<double> weight_to_parent;
 
-    TreePathMaxima(std::vector<BottomUpQuery> queries, LCA& lca);
+    // the arrays are allocated from the resource of lca
+    TreePathMaxima(std::span<BottomUpQuery const> queries, LCA& lca);
 
     double weight(Vertex u) {
         return weight_to_parent[u];
@@ -51,11 +65,53 @@ struct TreePathMaxima {
     size_t binary_search(double w, size_t S);
     void visit(Vertex v, size_t S);
     void assign_queries_to_leafs();
-    size_t subsets(size_t n,size_t k,size_t p);
-    void compute_median_table(size_t h);
     void propagate_query_sets_up();
 
     // just for debugin of the efficient representation
     std::vector<std::vector<size_t>> query_per_leaf();
 
 };
+
+// TreePathMaxima for trees of any depth. The sets of depths are bitsets of
+// words_per_set words and the median of a set is found by rank and select
+// over its words, so there is no median table growing with the depth. The
+// dfs is iterative and the answer sets are kept only for the current path.
+struct TreePathMaximaWide {
+    RootedTree const& tree; // must be a fully branching tree
+    Vertex root;
+    size_t depth;
+    size_t words_per_set;
+    LCA& lca;
+    std::pmr::vector<BottomUpQuery> queries;
+    // leafs to queries
+    std::pmr::vector<size_t> first_query; // first query in leaf
+    std::pmr::vector<size_t> next_query; // links to the next query for the same leaf
+
+    // words_per_set words for each vertex
+    std::pmr::vector<uint64_t> query_sets;
+    // here will be the answer to each query, encoded as vertex whose edge
+    // to parent is the maximal
+    std::pmr::vector<Vertex> answers;
+
+    std::pmr::vector<std::pmr::vector<Vertex>> rows; // rows of vetexes in each depth
+    std::pmr::vector<size_t> visit_stack;
+    std::pmr::vector<double> weight_to_parent;
+
+    // the arrays are allocated from the resource of lca
+    TreePathMaximaWide(std::span<BottomUpQuery const> queries, LCA& lca);
+
+    double weight(Vertex u) {
+        return weight_to_parent[u];
+    }
+
+    uint64_t* query_set(Vertex u) {
+        return query_sets.data() + u * words_per_set;
+    }
+
+    void compute_parent_weights();
+    // S is overwritten
+    size_t binary_search(double w, uint64_t* S);
+    void visit_all();
+    void assign_queries_to_leafs();
+    void propagate_query_sets_up();
+};
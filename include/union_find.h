@@ -0,0 +1,125 @@
+#pragma once
+
+#include "csr_graph.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+// Sequential union find in a single array, the entry of a root has the high
+// bit set and its rank in the low bits, the entry of any other vertex is its
+// parent. Union by rank keeps the trees of depth O(log n) and find halves
+// the path, so the amortized cost is inverse ackermann.
+class UnionFind {
+    public:
+    UnionFind(size_t size, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : parent(size, root_bit, resource)
+    {
+        assert(size < root_bit);
+    }
+
+    VertexId find(VertexId u) {
+        while (!(parent[u] & root_bit)) {
+            auto p = parent[u];
+            if (parent[p] & root_bit) {
+                return p;
+            }
+            parent[u] = parent[p];
+            u = parent[u];
+        }
+        return u;
+    }
+
+    // returns true if the call merged the two sets
+    bool unite(VertexId u, VertexId v) {
+        u = find(u);
+        v = find(v);
+        if (u == v) {
+            return false;
+        }
+        link(u, v);
+        return true;
+    }
+
+    // u and v have to be different roots
+    void link(VertexId u, VertexId v) {
+        auto u_rank = parent[u] & ~root_bit;
+        auto v_rank = parent[v] & ~root_bit;
+        if (u_rank < v_rank) {
+            std::swap(u, v);
+        } else if (u_rank == v_rank) {
+            parent[u]++;
+        }
+        parent[v] = u;
+    }
+
+    bool same_set(VertexId u, VertexId v) {
+        return find(u) == find(v);
+    }
+
+    size_t size() const {
+        return parent.size();
+    }
+
+    private:
+    static constexpr uint32_t root_bit = uint32_t{1} << 31;
+
+    std::pmr::vector<uint32_t> parent;
+};
+
+// Union find which can be used from multiple threads at once without locks.
+// Roots are linked by index, the root with larger index is pointed to the
+// smaller one by CAS, so the parent of a vertex is always smaller than the
+// vertex and no cycles can be created by concurrent unions.
+class ConcurrentUnionFind {
+    public:
+    ConcurrentUnionFind(size_t size) : parent(size) {
+        for (size_t u = 0; u < size; u++) {
+            parent[u].store(u, std::memory_order_relaxed);
+        }
+    }
+
+    // with path halving, a failed CAS only means that another thread already
+    // moved the vertex higher
+    VertexId find(VertexId u) {
+        while (true) {
+            VertexId p = parent[u].load(std::memory_order_acquire);
+            if (p == u) {
+                return u;
+            }
+            VertexId gp = parent[p].load(std::memory_order_acquire);
+            if (p != gp) {
+                parent[u].compare_exchange_weak(p, gp, std::memory_order_release, std::memory_order_relaxed);
+            }
+            u = gp;
+        }
+    }
+
+    // returns true if this call merged the two sets
+    bool unite(VertexId u, VertexId v) {
+        while (true) {
+            u = find(u);
+            v = find(v);
+            if (u == v) {
+                return false;
+            }
+            if (u < v) {
+                std::swap(u, v);
+            }
+            VertexId expected = u;
+            if (parent[u].compare_exchange_strong(expected, v, std::memory_order_acq_rel)) {
+                return true;
+            }
+        }
+    }
+
+    bool same_set(VertexId u, VertexId v) {
+        return find(u) == find(v);
+    }
+
+    private:
+    std::vector<std::atomic<VertexId>> parent;
+};
@@ -19,8 +19,8 @@ T log2(T n) {
 }
 
 
-template<typename T>
-std::string dump_vector(const std::vector<T>& arr) {
+template<typename T, typename Allocator>
+std::string dump_vector(const std::vector<T, Allocator>& arr) {
     auto res = std::string{};
     for (const auto& elem : arr) {
         res += std::to_string(elem) + " ";
@@ -61,21 +61,6 @@ struct PairHash {
     }
 };
 
-// who added ranges to c++20 without collect????????
-inline std::vector<std::string> collect(auto iter) {
-    std::vector<std::string> res{};
-    for (const auto& part : iter) {
-        std::string s{};
-        // WTF
-        for (auto e : part) {
-            s.push_back(e);
-        }
-        res.push_back(s);
-    }
-    return res;
-}
-
-
 inline bool is_close(double a, double b, double tol=0.001) {
     return std::fabs(a - b) <= tol;
 }
@@ -0,0 +1,79 @@
+// Compares online lca over the rmq tables with offline tarjan lca on a random
+// tree for growing query counts. The query times don't include building the
+// euler tour with the rmq tables (rmq_build) or without them (tour_build),
+// which are reported once, the verification pays one of them for every
+// tree.
+#include "lca.h"
+#include "offline_lca.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+template<typename F>
+double time_ms(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? std::stoull(argv[1]) : 1'000'000;
+    size_t max_queries = argc > 2 ? std::stoull(argv[2]) : 4 * n;
+
+    auto rng = std::mt19937_64{42};
+    auto edges = std::vector<std::pair<size_t, size_t>>{};
+    auto weights = std::vector<double>{};
+    for (size_t v = 1; v < n; v++) {
+        edges.emplace_back(std::uniform_int_distribution<size_t>(0, v - 1)(rng), v);
+        weights.push_back(v);
+    }
+    auto tree = GraphType(edges.begin(), edges.end(), weights.begin(), n);
+    auto dist = std::uniform_int_distribution<Vertex>(0, n - 1);
+
+    std::cout << "queries,method,time_ms\n";
+    auto lca = std::optional<LCA>{};
+    auto build_time = time_ms([&] {
+        lca.emplace(tree, 0);
+    });
+    auto tour = std::optional<LCA>{};
+    auto tour_time = time_ms([&] {
+        tour.emplace(tree, 0, false);
+    });
+    std::cout << "0,rmq_build," << build_time << "\n";
+    std::cout << "0,tour_build," << tour_time << "\n";
+    for (size_t count = 1000; count <= max_queries; count *= 4) {
+        auto queries = std::vector<std::pair<Vertex, Vertex>>(count);
+        for (auto& q : queries) {
+            q = {dist(rng), dist(rng)};
+        }
+        auto online = std::pmr::vector<Vertex>(count);
+        auto many = std::pmr::vector<Vertex>{};
+        auto offline = std::pmr::vector<Vertex>{};
+        auto online_time = time_ms([&] {
+            for (size_t i = 0; i < count; i++) {
+                online[i] = lca->lca(queries[i].first, queries[i].second);
+            }
+        });
+        auto many_time = time_ms([&] {
+            many = lca->lca_many(queries);
+        });
+        auto offline_time = time_ms([&] {
+            offline = offline_lca(*tour, queries);
+        });
+        if (online != many || online != offline) {
+            std::cerr << "the lca methods disagree\n";
+            return 1;
+        }
+        std::cout << count << ",rmq_lca," << online_time << "\n";
+        std::cout << count << ",rmq_lca_many," << many_time << "\n";
+        std::cout << count << ",offline," << offline_time << "\n";
+    }
+}
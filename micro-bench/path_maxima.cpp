@@ -0,0 +1,65 @@
+// Times forest_path_maxima, the verification step of RandomKKT, on random
+// forests of growing size. The recursion of KKT verifies many small forests,
+// so the fixed cost of a call, like building the median table of the tree
+// depth, matters as much as the cost per query. The first call of a size
+// also builds the median tables which are then shared by the later calls.
+#include "mst_verify.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+template<typename F>
+double time_us(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+int main(int argc, char** argv) {
+    size_t max_vertexes = argc > 1 ? std::stoull(argv[1]) : 1'000'000;
+    size_t total_vertexes = argc > 2 ? std::stoull(argv[2]) : 4 * max_vertexes;
+
+    auto rng = std::mt19937_64{42};
+    auto weight_dist = std::uniform_real_distribution<double>(0, 1);
+
+    std::cout << "vertexes,components,calls,first_call_us,mean_call_us\n";
+    for (size_t n = 100; n <= max_vertexes; n *= 10) {
+        // the vertexes below components are the roots of the trees
+        size_t components = n / 10;
+        auto forest = std::vector<std::tuple<Vertex, Vertex, double>>{};
+        for (size_t v = components; v < n; v++) {
+            auto u = std::uniform_int_distribution<size_t>(0, v - 1)(rng);
+            forest.emplace_back(u, v, weight_dist(rng));
+        }
+        auto dist = std::uniform_int_distribution<Vertex>(0, n - 1);
+        auto queries = std::vector<std::tuple<Vertex, Vertex, double>>(2 * n);
+        for (auto& q : queries) {
+            q = {dist(rng), dist(rng), weight_dist(rng)};
+        }
+
+        size_t calls = std::max<size_t>(2, total_vertexes / n);
+        size_t answered = 0;
+        auto first = time_us([&] {
+            answered += forest_path_maxima(n, forest, queries).size();
+        });
+        auto rest = time_us([&] {
+            for (size_t i = 1; i < calls; i++) {
+                answered += forest_path_maxima(n, forest, queries).size();
+            }
+        });
+        if (answered != calls * queries.size()) {
+            std::cerr << "missing path maxima\n";
+            return 1;
+        }
+        std::cout << n << "," << components << "," << calls << ","
+            << first << "," << rest / (calls - 1) << "\n";
+    }
+}
@@ -0,0 +1,149 @@
+// Compares the union find implementations on the find/union patterns of the
+// algorithms: kruskal queries every edge in weight order, borůvka unites the
+// lightest edge of every component per round and the parallel algorithms
+// unite the edges from multiple threads.
+#include "union_find.h"
+
+#include <boost/pending/disjoint_sets.hpp>
+#include <boost/property_map/property_map.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using Edges = std::vector<std::pair<VertexId, VertexId>>;
+
+// random graph with the edges in the order kruskal takes them
+Edges random_edges(size_t n, size_t m, uint64_t seed) {
+    auto rng = std::mt19937_64{seed};
+    auto dist = std::uniform_int_distribution<VertexId>(0, n - 1);
+    auto edges = Edges{};
+    edges.reserve(m);
+    for (size_t i = 0; i < m; i++) {
+        edges.emplace_back(dist(rng), dist(rng));
+    }
+    return edges;
+}
+
+// pairs of (representative, target) like borůvka unites the lightest
+// edge of every component, repeated on the contracted graph
+Edges boruvka_pattern(size_t n, uint64_t seed) {
+    auto rng = std::mt19937_64{seed};
+    auto order = std::vector<VertexId>(n);
+    for (size_t u = 0; u < n; u++) {
+        order[u] = u;
+    }
+    auto edges = Edges{};
+    while (order.size() > 1) {
+        std::shuffle(order.begin(), order.end(), rng);
+        auto next = std::vector<VertexId>{};
+        for (size_t i = 0; i + 1 < order.size(); i += 2) {
+            edges.emplace_back(order[i], order[i + 1]);
+            next.push_back(order[i]);
+        }
+        if (order.size() % 2) {
+            next.push_back(order.back());
+        }
+        order = std::move(next);
+    }
+    return edges;
+}
+
+template<typename F>
+double time_ms(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+template<typename UF>
+size_t run_pattern(UF& uf, Edges const& edges) {
+    size_t merged = 0;
+    for (auto [u, v] : edges) {
+        if (!uf.same_set(u, v)) {
+            uf.unite(u, v);
+            merged++;
+        }
+    }
+    return merged;
+}
+
+// boost::disjoint_sets set up as the algorithms used it
+struct BoostUnionFind {
+    std::vector<size_t> rank;
+    std::vector<VertexId> paren;
+    boost::disjoint_sets<size_t*, VertexId*> dsets;
+
+    BoostUnionFind(size_t n) : rank(n), paren(n), dsets(rank.data(), paren.data()) {
+        for (size_t u = 0; u < n; u++) {
+            dsets.make_set(u);
+        }
+    }
+
+    bool same_set(VertexId u, VertexId v) {
+        return dsets.find_set(u) == dsets.find_set(v);
+    }
+
+    void unite(VertexId u, VertexId v) {
+        dsets.union_set(u, v);
+    }
+};
+
+void bench_pattern(std::string const& name, size_t n, Edges const& edges) {
+    size_t merged[3];
+    double times[3];
+    times[0] = time_ms([&] {
+        auto uf = BoostUnionFind(n);
+        merged[0] = run_pattern(uf, edges);
+    });
+    times[1] = time_ms([&] {
+        auto uf = UnionFind(n);
+        merged[1] = run_pattern(uf, edges);
+    });
+    times[2] = time_ms([&] {
+        auto uf = ConcurrentUnionFind(n);
+        merged[2] = run_pattern(uf, edges);
+    });
+    if (merged[0] != merged[1] || merged[0] != merged[2]) {
+        std::cerr << name << ": the union finds disagree\n";
+        std::exit(1);
+    }
+    std::cout << name << ",boost_disjoint_sets," << times[0] << "\n";
+    std::cout << name << ",union_find," << times[1] << "\n";
+    std::cout << name << ",concurrent_union_find," << times[2] << "\n";
+}
+
+void bench_parallel(size_t n, Edges const& edges, size_t threads) {
+    auto uf = ConcurrentUnionFind(n);
+    auto time = time_ms([&] {
+        auto workers = std::vector<std::jthread>{};
+        for (size_t t = 0; t < threads; t++) {
+            workers.emplace_back([&, t] {
+                for (size_t i = t; i < edges.size(); i += threads) {
+                    uf.unite(edges[i].first, edges[i].second);
+                }
+            });
+        }
+    });
+    std::cout << "parallel_" << threads << ",concurrent_union_find," << time << "\n";
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? std::stoull(argv[1]) : 1'000'000;
+    size_t m = argc > 2 ? std::stoull(argv[2]) : 10 * n;
+    size_t threads = argc > 3 ? std::stoull(argv[3]) : std::thread::hardware_concurrency();
+
+    std::cout << "pattern,union_find,time_ms\n";
+    auto edges = random_edges(n, m, 42);
+    bench_pattern("kruskal", n, edges);
+    bench_pattern("boruvka", n, boruvka_pattern(n, 42));
+    bench_parallel(n, edges, std::max<size_t>(threads, 1));
+}
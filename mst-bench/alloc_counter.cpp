@@ -0,0 +1,157 @@
+#include "alloc_counter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <malloc.h>
+#include <new>
+#include <string>
+
+namespace {
+
+std::atomic<bool> enabled = false;
+std::atomic<uint64_t> allocations = 0;
+std::atomic<uint64_t> bytes = 0;
+// signed, memory allocated before the start can be freed during counting
+std::atomic<int64_t> live = 0;
+std::atomic<int64_t> peak_live = 0;
+
+void on_alloc(void* ptr) {
+    if (ptr == nullptr || !enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    // the usable size is used for both ends, so the live bytes match
+    int64_t size = malloc_usable_size(ptr);
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(size, std::memory_order_relaxed);
+    auto now = live.fetch_add(size, std::memory_order_relaxed) + size;
+    auto peak = peak_live.load(std::memory_order_relaxed);
+    while (now > peak && !peak_live.compare_exchange_weak(peak, now, std::memory_order_relaxed)) { }
+}
+
+void on_free(void* ptr) {
+    if (ptr == nullptr || !enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    live.fetch_sub(malloc_usable_size(ptr), std::memory_order_relaxed);
+}
+
+void* allocate(size_t size) {
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    on_alloc(ptr);
+    return ptr;
+}
+
+void* allocate(size_t size, std::align_val_t align) {
+    void* ptr = nullptr;
+    auto alignment = std::max(static_cast<size_t>(align), sizeof(void*));
+    if (::posix_memalign(&ptr, alignment, size == 0 ? 1 : size) != 0) {
+        ptr = nullptr;
+    }
+    on_alloc(ptr);
+    return ptr;
+}
+
+void deallocate(void* ptr) {
+    on_free(ptr);
+    std::free(ptr);
+}
+
+} // namespace
+
+void start_allocation_counting() {
+    allocations = 0;
+    bytes = 0;
+    live = 0;
+    peak_live = 0;
+    enabled = true;
+}
+
+AllocationStats stop_allocation_counting() {
+    enabled = false;
+    auto res = AllocationStats{};
+    res.allocations = allocations;
+    res.bytes = bytes;
+    res.peak_live_bytes = peak_live;
+    return res;
+}
+
+// reads the "<field>: <value> kB" line from /proc/self/status
+static size_t status_field_bytes(std::string const& field) {
+    auto is = std::ifstream("/proc/self/status");
+    auto line = std::string{};
+    while (std::getline(is, line)) {
+        if (line.starts_with(field + ":")) {
+            return std::stoull(line.substr(field.size() + 1)) * 1024;
+        }
+    }
+    return 0;
+}
+
+size_t current_rss_bytes() {
+    return status_field_bytes("VmRSS");
+}
+
+size_t peak_rss_bytes() {
+    return status_field_bytes("VmHWM");
+}
+
+bool reset_peak_rss() {
+    // 5 resets the peak to the current rss, since linux 4.0
+    auto os = std::ofstream("/proc/self/clear_refs");
+    os << "5";
+    os.flush();
+    return static_cast<bool>(os);
+}
+
+void* operator new(size_t size) {
+    if (void* ptr = allocate(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, std::nothrow_t const&) noexcept {
+    return allocate(size);
+}
+
+void* operator new[](size_t size, std::nothrow_t const&) noexcept {
+    return allocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t align) {
+    if (void* ptr = allocate(size, align)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t align) {
+    return operator new(size, align);
+}
+
+void* operator new(size_t size, std::align_val_t align, std::nothrow_t const&) noexcept {
+    return allocate(size, align);
+}
+
+void* operator new[](size_t size, std::align_val_t align, std::nothrow_t const&) noexcept {
+    return allocate(size, align);
+}
+
+void operator delete(void* ptr) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr) noexcept { deallocate(ptr); }
+void operator delete(void* ptr, size_t) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { deallocate(ptr); }
+void operator delete(void* ptr, std::nothrow_t const&) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr, std::nothrow_t const&) noexcept { deallocate(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { deallocate(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { deallocate(ptr); }
+void operator delete(void* ptr, std::align_val_t, std::nothrow_t const&) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr, std::align_val_t, std::nothrow_t const&) noexcept { deallocate(ptr); }
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Counts of the heap allocations done through operator new, the replaced
+// global operators in alloc_counter.cpp count only while it is enabled,
+// so the timed runs don't pay for the atomics.
+struct AllocationStats {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    // the most live bytes above the live bytes at start
+    uint64_t peak_live_bytes = 0;
+};
+
+void start_allocation_counting();
+AllocationStats stop_allocation_counting();
+
+// resident set size of the process in bytes, 0 when it can't be read
+size_t current_rss_bytes();
+// the peak resident set size since start or the last successful reset
+size_t peak_rss_bytes();
+bool reset_peak_rss();
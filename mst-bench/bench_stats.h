@@ -0,0 +1,91 @@
+#pragma once
+
+#include "utils.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// summary of the timings of repeated runs, all times are in nanoseconds
+struct RunStats {
+    std::vector<uint64_t> times;
+    double mean = 0;
+    double min = 0;
+    double median = 0;
+    double p90 = 0;
+    double max = 0;
+    double stddev = 0;
+    // 95% confidence interval of the mean
+    double ci_low = 0;
+    double ci_high = 0;
+};
+
+// two sided 97.5% quantile of the student t distribution, the normal one is
+// close enough from 30 degrees of freedom
+inline double t_quantile_975(size_t df) {
+    constexpr auto table = std::array<double, 30>{
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (df == 0) {
+        return 0;
+    }
+    return df <= table.size() ? table[df - 1] : 1.96;
+}
+
+// the percentile by nearest rank of sorted values
+inline double percentile(std::vector<uint64_t> const& sorted, double p) {
+    auto rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+inline RunStats summarize_runs(std::vector<uint64_t> times) {
+    auto res = RunStats{};
+    res.times = times;
+    if (times.empty()) {
+        return res;
+    }
+    std::sort(times.begin(), times.end());
+    size_t n = times.size();
+    res.mean = std::accumulate(times.begin(), times.end(), 0.0) / n;
+    res.min = times.front();
+    res.max = times.back();
+    res.median = n % 2 ? times[n / 2] : (times[n / 2 - 1] + times[n / 2]) / 2.0;
+    res.p90 = percentile(times, 0.9);
+    if (n > 1) {
+        double sq_sum = 0;
+        for (auto t : times) {
+            sq_sum += (t - res.mean) * (t - res.mean);
+        }
+        res.stddev = std::sqrt(sq_sum / (n - 1));
+    }
+    double half_width = t_quantile_975(n - 1) * res.stddev / std::sqrt(n);
+    res.ci_low = res.mean - half_width;
+    res.ci_high = res.mean + half_width;
+    return res;
+}
+
+inline std::string to_json(RunStats const& stats, std::vector<std::pair<std::string, std::string>> dict = {}) {
+    auto fmt = [](double ns) {
+        return std::to_string(static_cast<uint64_t>(std::llround(std::max(0.0, ns))));
+    };
+    dict.emplace_back("runs", std::to_string(stats.times.size()));
+    dict.emplace_back("mean_ns", fmt(stats.mean));
+    dict.emplace_back("min_ns", fmt(stats.min));
+    dict.emplace_back("median_ns", fmt(stats.median));
+    dict.emplace_back("p90_ns", fmt(stats.p90));
+    dict.emplace_back("max_ns", fmt(stats.max));
+    dict.emplace_back("stddev_ns", fmt(stats.stddev));
+    dict.emplace_back("ci95_low_ns", fmt(stats.ci_low));
+    dict.emplace_back("ci95_high_ns", fmt(stats.ci_high));
+    auto times = std::string{"["};
+    for (size_t i = 0; i < stats.times.size(); i++) {
+        times += (i == 0 ? "" : ", ") + std::to_string(stats.times[i]);
+    }
+    dict.emplace_back("times_ns", times + "]");
+    return to_json(dict);
+}
@@ -1,58 +1,88 @@
 #include "graph.h"
+#include "dynamic_mst.h"
 #include "mst_algorithms.h"
+#include "mst_verify.h"
+#include "sliding_window_msf.h"
 #include "lca.h"
 #include "utils.h"
+#include "alloc_counter.h"
+#include "bench_stats.h"
+#include "perf_counters.h"
 
 #include <algorithm>
 #include <chrono>
 #include <exception>
 #include <filesystem>
+#include <fstream>
+#include <future>
 #include <iostream>
 
 #include <argparse/argparse.hpp>
 #include <memory>
+#include <optional>
 #include <stdexcept>
+#include <unordered_map>
 #include <unordered_set>
 
 
+using Clc = std::chrono::steady_clock;
+
+static uint64_t elapsed_ns(Clc::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clc::now() - start).count();
+}
+
+struct LoadedGraph {
+    Graph graph;
+    uint64_t load_ns;
+};
+
+static LoadedGraph timed_parse_graph(std::filesystem::path graph_file, size_t threads) {
+    auto start = Clc::now();
+    auto g = parse_graph(graph_file, threads);
+    return {std::move(g), elapsed_ns(start)};
+}
+
 struct AlgRunner {
     std::filesystem::path graph_file;
+    uint64_t load_ns;
     Graph graph;
-    std::vector<std::shared_ptr<MSTAlgorithm>> algs_to_run;
+    std::vector<std::pair<std::string, AlgorithmFactory>> algs_to_run;
 
-    AlgRunner(std::filesystem::path graph_file, std::vector<std::string> filter)
+    AlgRunner(std::filesystem::path graph_file, std::vector<std::string> filter, size_t threads)
+        : AlgRunner(graph_file, timed_parse_graph(graph_file, threads), filter, threads)
+    { }
+
+    AlgRunner(std::filesystem::path graph_file, LoadedGraph loaded, std::vector<std::string> filter, size_t threads)
         : graph_file(graph_file)
-        , graph(parse_graph(graph_file))
-        , algs_to_run(get_algorithms(graph))
+        , load_ns(loaded.load_ns)
+        , graph(std::move(loaded.graph))
+        , algs_to_run(get_algorithm_factories(threads))
     {
         if (!filter.empty()) {
             auto filter_s = std::unordered_set<std::string>{};
             filter_s.insert(filter.begin(), filter.end());
-            for (auto it = algs_to_run.begin(); it != algs_to_run.end(); ) {
-                if (filter_s.contains(it->get()->name)) {
-                    it = algs_to_run.erase(it);
-                } else {
-                    ++it;
-                }
-            }
+            std::erase_if(algs_to_run, [&](auto const& alg) { return filter_s.contains(alg.first); });
         }
     }
 
     virtual void run() {
-        for (auto alg : algs_to_run) {
-            run_on_alg(*alg);
+        for (auto& [name, make] : algs_to_run) {
+            auto start = Clc::now();
+            auto alg = make(graph);
+            auto setup_ns = elapsed_ns(start);
+            run_on_alg(*alg, setup_ns);
         }
     }
 
-    virtual void run_on_alg(MSTAlgorithm& alg) = 0;
+    virtual void run_on_alg(MSTAlgorithm& alg, uint64_t setup_ns) = 0;
 };
 
 struct TestRunner : public AlgRunner {
     double ref_res;
     std::vector<bool> results;
 
-    TestRunner(std::filesystem::path graph_file, std::vector<std::string> filter)
-        : AlgRunner(graph_file, filter)
+    TestRunner(std::filesystem::path graph_file, std::vector<std::string> filter, size_t threads)
+        : AlgRunner(graph_file, filter, threads)
         , ref_res(graph.mst_weight())
         , results()
     { }
@@ -62,7 +92,7 @@ struct TestRunner : public AlgRunner {
         AlgRunner::run();
     }
 
-    void run_on_alg(MSTAlgorithm &alg) override {
+    void run_on_alg(MSTAlgorithm &alg, uint64_t) override {
             auto mst = alg.compute_mst();
             double res = alg.mst_weight(mst);
             if (is_close(res, ref_res)) {
@@ -75,47 +105,404 @@ struct TestRunner : public AlgRunner {
     std::string res_as_json() {
         auto dict = std::vector<std::pair<std::string, std::string>>{};
         for (size_t i = 0; i < algs_to_run.size(); i++) {
-            dict.emplace_back(algs_to_run[i]->name, bool_to_str(results[i]));
+            dict.emplace_back(algs_to_run[i].first, bool_to_str(results[i]));
         }
         return to_json(dict);
     }
 };
 
+struct BenchConfig {
+    size_t warmup = 1;
+    // the runs continue until both are reached
+    size_t repetitions = 10;
+    double min_seconds = 0;
+    bool perf = false;
+    bool memory = false;
+    // the mst of the first run is compared with the boost kruskal
+    bool check = false;
+};
+
 struct BenchRunner : public AlgRunner {
-    double ref_res;
-    std::vector<size_t> results;
+    BenchConfig config;
+    std::unique_ptr<PerfCounters> counters;
+    std::optional<double> ref_res;
+    std::vector<std::string> results;
+    std::vector<RunStats> run_stats;
+    std::vector<bool> correct;
 
-    BenchRunner(std::filesystem::path graph_file, std::vector<std::string> filter)
-        : AlgRunner(graph_file, filter)
-        , ref_res(graph.mst_weight())
-        , results()
+    BenchRunner(std::filesystem::path graph_file, std::vector<std::string> filter, size_t threads, BenchConfig config)
+        : BenchRunner(graph_file, timed_parse_graph(graph_file, threads), filter, threads, config)
     { }
 
+    BenchRunner(std::filesystem::path graph_file, LoadedGraph loaded, std::vector<std::string> filter, size_t threads, BenchConfig config)
+        : AlgRunner(graph_file, std::move(loaded), filter, threads)
+        , config(config)
+        , counters(config.perf ? std::make_unique<PerfCounters>() : nullptr)
+        , ref_res()
+        , results()
+    {
+        if (config.check) {
+            ref_res = graph.mst_weight();
+        }
+        if (counters && !counters->available()) {
+            std::cerr << "perf counters are not available, running without them\n";
+        }
+    }
+
+    bool use_counters() const {
+        return counters && counters->available();
+    }
+
     virtual void run() override {
         std::cerr << "running bench on " << graph_file << ":\n";
         AlgRunner::run();
     }
 
-    void run_on_alg(MSTAlgorithm &alg) override {
-        size_t runs = 10;
-        using Clc = std::chrono::steady_clock;
-        auto start = Clc::now();
-        for (size_t i = 0; i < runs; i++) {
+    // the warmup runs also build the lazy state of the graph, like the boost
+    // adjacency list, so it is not counted in the first timed run
+    void run_on_alg(MSTAlgorithm &alg, uint64_t setup_ns) override {
+        size_t warmup = config.warmup;
+        if (ref_res) {
+            // the checked run counts as warmup
+            correct.push_back(is_close(alg.mst_weight(alg.compute_mst()), *ref_res));
+            warmup -= std::min<size_t>(warmup, 1);
+        }
+        for (size_t i = 0; i < warmup; i++) {
+            alg.compute_mst();
+        }
+        auto times = std::vector<uint64_t>{};
+        auto min_ns = static_cast<uint64_t>(config.min_seconds * 1e9);
+        uint64_t total_ns = 0;
+        // a counter whose read failed in some runs is averaged over the runs
+        // it was read in
+        struct CounterSum {
+            std::string name;
+            double sum;
+            size_t runs;
+        };
+        auto counter_sums = std::vector<CounterSum>{};
+        while (times.size() < config.repetitions || total_ns < min_ns) {
+            if (use_counters()) {
+                counters->start();
+            }
+            auto start = Clc::now();
             alg.compute_mst();
+            times.push_back(elapsed_ns(start));
+            total_ns += times.back();
+            if (use_counters()) {
+                counters->stop();
+                for (auto& [name, value] : counters->read()) {
+                    auto it = std::find_if(counter_sums.begin(), counter_sums.end(), [&](auto& c) {
+                        return c.name == name;
+                    });
+                    if (it == counter_sums.end()) {
+                        it = counter_sums.insert(it, {name, 0.0, 0});
+                    }
+                    it->sum += value;
+                    it->runs++;
+                }
+            }
+        }
+        auto dict = alg.stats();
+        dict.emplace(dict.begin(), "setup_ns", std::to_string(setup_ns));
+        if (use_counters()) {
+            // mean per run
+            auto perf = std::vector<std::pair<std::string, std::string>>{};
+            for (auto& counter : counter_sums) {
+                perf.emplace_back(counter.name, std::to_string(static_cast<uint64_t>(counter.sum / counter.runs)));
+            }
+            dict.emplace_back("perf", to_json(perf));
+        }
+        if (config.memory) {
+            dict.emplace_back("memory", measure_memory(alg));
+        }
+        run_stats.push_back(summarize_runs(std::move(times)));
+        results.push_back(to_json(run_stats.back(), dict));
+    }
+
+    // one more untimed run with the allocations counted, the rss grows only
+    // when the run needs more memory than the allocator kept from the
+    // previous runs
+    std::string measure_memory(MSTAlgorithm& alg) {
+        bool peak_reset = reset_peak_rss();
+        auto rss_before = current_rss_bytes();
+        start_allocation_counting();
+        alg.compute_mst();
+        auto allocs = stop_allocation_counting();
+        auto rss_after = current_rss_bytes();
+        auto memory = std::vector<std::pair<std::string, std::string>>{};
+        memory.emplace_back("allocations", std::to_string(allocs.allocations));
+        memory.emplace_back("bytes_allocated", std::to_string(allocs.bytes));
+        memory.emplace_back("peak_live_bytes", std::to_string(allocs.peak_live_bytes));
+        memory.emplace_back("rss_delta_bytes", std::to_string(static_cast<int64_t>(rss_after - rss_before)));
+        if (peak_reset) {
+            memory.emplace_back("peak_rss_delta_bytes", std::to_string(peak_rss_bytes() - rss_before));
         }
-        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clc::now() - start);
-        results.push_back(elapsed.count() / runs);
+        return to_json(memory);
     }
 
     std::string res_as_json() {
-        auto dict = std::vector<std::pair<std::string, std::string>>{};
+        auto algs = std::vector<std::pair<std::string, std::string>>{};
         for (size_t i = 0; i < algs_to_run.size(); i++) {
-            dict.emplace_back(algs_to_run[i]->name, std::to_string(results[i]));
+            algs.emplace_back(algs_to_run[i].first, results[i]);
+        }
+        auto dict = std::vector<std::pair<std::string, std::string>>{};
+        dict.emplace_back("load_ns", std::to_string(load_ns));
+        if (config.perf) {
+            dict.emplace_back("perf_available", bool_to_str(use_counters()));
         }
+        dict.emplace_back("algs", to_json(algs));
         return to_json(dict);
     }
 };
 
+// the graph files in the directory or the lines of the manifest file, the
+// paths in the manifest are relative to its directory
+static std::vector<std::filesystem::path> batch_inputs(std::filesystem::path input) {
+    auto res = std::vector<std::filesystem::path>{};
+    if (std::filesystem::is_directory(input)) {
+        for (auto& entry : std::filesystem::directory_iterator(input)) {
+            if (entry.is_regular_file()) {
+                res.push_back(entry.path());
+            }
+        }
+        std::sort(res.begin(), res.end());
+        return res;
+    }
+    auto is = std::ifstream(input);
+    if (!is) {
+        throw std::runtime_error("failed to open manifest: " + input.string() + "\n");
+    }
+    auto line = std::string{};
+    while (std::getline(is, line)) {
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (line.empty() || line.starts_with('#')) {
+            continue;
+        }
+        res.push_back(input.parent_path() / line);
+    }
+    return res;
+}
+
+// Runs info, test and bench on every graph with one parse per graph. The
+// bench rows are streamed to out in the csv schema of mst_bench.py, the
+// info rows to info_out when given. With prefetch the next graph is parsed
+// by one more thread during the bench of the current one, so the bench
+// threads aren't oversubscribed. A file which fails to load is reported and
+// skipped. Returns false if some algorithm computed wrong mst.
+static bool run_batch(std::vector<std::filesystem::path> graphs, std::vector<std::string> filter,
+        size_t threads, BenchConfig config, bool prefetch, std::ostream& out, std::ostream* info_out) {
+    config.check = true;
+    bool all_correct = true;
+    size_t row = 0;
+    size_t info_row = 0;
+    out << ",path,alg,time\n";
+    if (info_out) {
+        *info_out << ",connected,unique_weights,vertices,edges,load_seconds,load_mb_per_s,path\n";
+    }
+    auto next = std::future<LoadedGraph>{};
+    if (prefetch && !graphs.empty()) {
+        next = std::async(std::launch::async, timed_parse_graph, graphs[0], threads);
+    }
+    for (size_t i = 0; i < graphs.size(); i++) {
+        auto path = graphs[i].string();
+        auto loaded = std::optional<LoadedGraph>{};
+        try {
+            loaded = prefetch ? next.get() : timed_parse_graph(graphs[i], threads);
+        } catch (std::exception const& e) {
+            std::cerr << "skipping " << path << ": " << e.what() << "\n";
+        }
+        if (prefetch && i + 1 < graphs.size()) {
+            next = std::async(std::launch::async, timed_parse_graph, graphs[i + 1], size_t{1});
+        }
+        if (!loaded) {
+            continue;
+        }
+        if (info_out) {
+            auto& g = loaded->graph;
+            auto load_seconds = loaded->load_ns / 1e9;
+            auto file_mb = std::filesystem::file_size(graphs[i]) / (1024.0 * 1024.0);
+            *info_out << info_row++ << ',' << (g.is_connected() ? "True" : "False")
+                << ',' << (g.has_unique_weights() ? "True" : "False")
+                << ',' << g.csr.num_vertices() << ',' << g.csr.num_edges()
+                << ',' << load_seconds << ',' << file_mb / load_seconds << ',' << path << std::endl;
+        }
+        auto runner = BenchRunner(graphs[i], std::move(*loaded), filter, threads, config);
+        runner.run();
+        for (size_t a = 0; a < runner.algs_to_run.size(); a++) {
+            auto& name = runner.algs_to_run[a].first;
+            if (!runner.correct[a]) {
+                all_correct = false;
+                std::cerr << name << " fails on " << path << "\n";
+            }
+            out << row++ << ',' << path << ',' << name << ','
+                << std::llround(runner.run_stats[a].mean / 1000) << std::endl;
+        }
+    }
+    return all_correct;
+}
+
+// The edge id of each "u v w" update, an update of an existing edge
+// decreases its weight and any other inserts the edge with the next id.
+// Prints the first update which increases a weight and returns nothing,
+// DynamicMST can't apply it.
+static std::optional<std::vector<EdgeId>> resolve_updates(CSRGraph const& csr, EdgeList const& updates) {
+    auto res = std::vector<EdgeId>(updates.size());
+    auto weights = std::vector<double>(csr.weights.begin(), csr.weights.end());
+    // the inserted edges are found by their ordered endpoints
+    auto inserted = std::unordered_map<std::pair<VertexId, VertexId>, EdgeId, PairHash<VertexId, VertexId>>{};
+    for (size_t i = 0; i < updates.size(); i++) {
+        auto u = updates.sources[i];
+        auto v = updates.targets[i];
+        auto e = csr.find_edge(u, v);
+        if (e == NoEdge) {
+            auto [it, is_new] = inserted.emplace(std::pair{std::min(u, v), std::max(u, v)}, weights.size());
+            e = it->second;
+            if (is_new) {
+                weights.push_back(updates.weights[i]);
+            }
+        }
+        if (updates.weights[i] > weights[e]) {
+            std::cerr << "update \"" << u << ' ' << v << ' ' << updates.weights[i]
+                << "\" increases the weight " << weights[e] << " of the edge" << std::endl;
+            return std::nullopt;
+        }
+        weights[e] = updates.weights[i];
+        res[i] = e;
+    }
+    return res;
+}
+
+// Replays the updates with their resolved edge ids. The DynamicMST starts
+// from the mst of the given algorithm and applies every update, only its
+// calls are timed. After every recompute_every updates and after the last
+// one the graph is rebuilt and its mst recomputed by Kruskal, which also
+// checks the maintained weight. Returns false if the weights differ.
+static bool replay_updates(Graph& g, EdgeList const& updates, std::vector<EdgeId> const& ids,
+        AlgorithmFactory const& make, size_t recompute_every, std::ostream& out) {
+    auto start = Clc::now();
+    auto alg = make(g);
+    auto initial_mst = alg->mst_edge_ids(alg->compute_mst());
+    auto initial_ns = elapsed_ns(start);
+    auto dynamic = DynamicMST(g.csr, initial_mst);
+
+    // the current graph for the recomputations
+    auto edges = EdgeList{};
+    edges.vertexes = g.csr.num_vertices();
+    edges.sources.assign(g.csr.sources.begin(), g.csr.sources.end());
+    edges.targets.assign(g.csr.targets.begin(), g.csr.targets.end());
+    edges.weights.assign(g.csr.weights.begin(), g.csr.weights.end());
+
+    uint64_t dynamic_ns = 0;
+    uint64_t rebuild_ns = 0;
+    uint64_t kruskal_ns = 0;
+    size_t recomputes = 0;
+    size_t decreases = 0;
+    bool correct = true;
+    for (size_t first = 0; first < updates.size() || recomputes == 0; first += recompute_every) {
+        size_t last = std::min(first + recompute_every, updates.size());
+        start = Clc::now();
+        for (size_t i = first; i < last; i++) {
+            if (ids[i] == dynamic.num_edges()) {
+                dynamic.insert_edge(updates.sources[i], updates.targets[i], updates.weights[i]);
+            } else {
+                dynamic.decrease_weight(ids[i], updates.weights[i]);
+            }
+        }
+        dynamic_ns += elapsed_ns(start);
+
+        for (size_t i = first; i < last; i++) {
+            if (ids[i] < edges.size()) {
+                edges.weights[ids[i]] = updates.weights[i];
+                decreases++;
+            } else {
+                edges.sources.push_back(updates.sources[i]);
+                edges.targets.push_back(updates.targets[i]);
+                edges.weights.push_back(updates.weights[i]);
+            }
+        }
+        start = Clc::now();
+        auto current = build_graph(edges);
+        rebuild_ns += elapsed_ns(start);
+        start = Clc::now();
+        auto kruskal = Kruskal(current);
+        auto mst = kruskal.compute_mst();
+        kruskal_ns += elapsed_ns(start);
+        correct = correct && is_close(kruskal.mst_weight(mst), dynamic.total_weight());
+        recomputes++;
+    }
+
+    size_t replaced = 0;
+    for (auto swap : dynamic.swaps()) {
+        replaced += swap.removed != NoEdge;
+    }
+    auto res = std::vector<std::pair<std::string, std::string>>{};
+    res.emplace_back("updates", std::to_string(updates.size()));
+    res.emplace_back("inserts", std::to_string(updates.size() - decreases));
+    res.emplace_back("decreases", std::to_string(decreases));
+    res.emplace_back("swaps", std::to_string(dynamic.swaps().size()));
+    res.emplace_back("replaced_edges", std::to_string(replaced));
+    res.emplace_back("initial_mst_ns", std::to_string(initial_ns));
+    res.emplace_back("dynamic_ns", std::to_string(dynamic_ns));
+    res.emplace_back("dynamic_ns_per_update", std::to_string(dynamic_ns / std::max<size_t>(1, updates.size())));
+    res.emplace_back("recomputes", std::to_string(recomputes));
+    res.emplace_back("rebuild_mean_ns", std::to_string(rebuild_ns / recomputes));
+    res.emplace_back("kruskal_mean_ns", std::to_string(kruskal_ns / recomputes));
+    res.emplace_back("mst_weight", std::to_string(dynamic.total_weight()));
+    res.emplace_back("correct", bool_to_str(correct));
+    out << to_json(res);
+    return correct;
+}
+
+// Streams the edges through a window of the last window_edges edges and of
+// the edges younger than window_time, a zero limit is not used. After every
+// report_every edges and after the last one a csv row with the weight of the
+// minimum spanning forest of the window is printed, with check it is also
+// recomputed by kruskal. The time per edge covers the window updates since
+// the previous row. Returns false if some checked weight differs.
+static bool run_stream(EdgeList const& stream, size_t window_edges, double window_time,
+        size_t report_every, bool check, std::ostream& out) {
+    auto msf = SlidingWindowMSF(stream.vertexes);
+    bool correct = true;
+    out << "edges,time,window_edges,forest_edges,mst_weight,ns_per_edge";
+    out << (check ? ",kruskal_weight\n" : "\n");
+    auto start = Clc::now();
+    size_t oldest = 0;
+    size_t reported = 0;
+    for (size_t i = 0; i < stream.size(); i++) {
+        auto now = stream.timestamps[i];
+        msf.push(stream.sources[i], stream.targets[i], stream.weights[i]);
+        while ((window_edges != 0 && msf.size() > window_edges)
+                || (window_time > 0 && stream.timestamps[oldest] <= now - window_time)) {
+            msf.pop();
+            oldest++;
+        }
+        if ((i + 1) % report_every == 0 || i + 1 == stream.size()) {
+            auto ns_per_edge = elapsed_ns(start) / (i + 1 - reported);
+            reported = i + 1;
+            out << i + 1 << ',' << now << ',' << msf.size() << ',' << msf.forest_size()
+                << ',' << msf.total_weight() << ',' << ns_per_edge;
+            if (check) {
+                auto weight = msf.kruskal_weight();
+                correct = correct && is_close(weight, msf.total_weight());
+                out << ',' << weight;
+            }
+            out << std::endl;
+            start = Clc::now();
+        }
+    }
+    return correct;
+}
+
+// the parallel algorithms need at least one thread
+static bool valid_threads(size_t threads) {
+    if (threads == 0) {
+        std::cerr << "--threads has to be at least 1" << std::endl;
+        return false;
+    }
+    return true;
+}
+
 int main(int argc , char** argv) {
     argparse::ArgumentParser program("mst-bench");
 
@@ -127,6 +514,10 @@ int main(int argc , char** argv) {
         .help("only run on the specified algorithms")
         .nargs(1, 10)
         .default_value(std::vector<std::string>{});
+    test_command.add_argument("--threads")
+        .help("number of threads used by the parallel algorithms")
+        .scan<'u', size_t>()
+        .default_value(default_thread_count());
 
     auto ls_command = argparse::ArgumentParser("ls");
     ls_command.add_description("list runable algorithms for computing mst");
@@ -144,11 +535,134 @@ int main(int argc , char** argv) {
         .help("only run on the specified algorithms")
         .nargs(1, 10)
         .default_value(std::vector<std::string>{});
+    bench_command.add_argument("--threads")
+        .help("number of threads used by the parallel algorithms")
+        .scan<'u', size_t>()
+        .default_value(default_thread_count());
+    bench_command.add_argument("--warmup")
+        .help("number of untimed runs before the timed ones")
+        .scan<'u', size_t>()
+        .default_value(size_t{1});
+    bench_command.add_argument("--repetitions")
+        .help("minimal number of timed runs")
+        .scan<'u', size_t>()
+        .default_value(size_t{10});
+    bench_command.add_argument("--min-time")
+        .help("minimal total time of the timed runs in seconds")
+        .scan<'g', double>()
+        .default_value(0.0);
+    bench_command.add_argument("--memory")
+        .help("count the heap allocations and the rss growth of one more run")
+        .default_value(false)
+        .implicit_value(true);
+    bench_command.add_argument("--perf")
+        .help("measure the timed runs with hardware performance counters")
+        .default_value(false)
+        .implicit_value(true);
+
+    auto convert_command = argparse::ArgumentParser("convert");
+    convert_command.add_description("converts graph to the binary format, which all commands can open without parsing");
+    convert_command.add_argument("graph")
+        .help("path to the file of the graph");
+    convert_command.add_argument("output")
+        .help("path of the binary graph file to create");
+
+    auto verify_command = argparse::ArgumentParser("verify");
+    verify_command.add_description("checks that the given tree is a minimum spanning tree of the graph, exits with 1 if not");
+    verify_command.add_argument("graph")
+        .help("path to the file of the graph");
+    verify_command.add_argument("tree")
+        .help("path to the file of the tree");
+    verify_command.add_argument("--format")
+        .help("format of the tree, edges (\"u v\" lines) or pred (parent of each vertex per line)")
+        .default_value("edges");
+    verify_command.add_argument("--max-violations")
+        .help("most violating edges to list")
+        .scan<'u', size_t>()
+        .default_value(size_t{20});
+    verify_command.add_argument("--lca")
+        .help("how the path queries find their lca, rmq (online tables) or offline (tarjan)")
+        .default_value("rmq");
+
+    auto batch_command = argparse::ArgumentParser("batch");
+    batch_command.add_description("runs info, test and bench on every graph of a directory or manifest with one parse per graph, prints the bench csv");
+    batch_command.add_argument("input")
+        .help("directory of graphs or file with one graph path per line");
+    batch_command.add_argument("--filter")
+        .help("only run on the specified algorithms")
+        .nargs(1, 10)
+        .default_value(std::vector<std::string>{});
+    batch_command.add_argument("--threads")
+        .help("number of threads used by the parallel algorithms")
+        .scan<'u', size_t>()
+        .default_value(default_thread_count());
+    batch_command.add_argument("--warmup")
+        .help("number of untimed runs before the timed ones")
+        .scan<'u', size_t>()
+        .default_value(size_t{1});
+    batch_command.add_argument("--repetitions")
+        .help("minimal number of timed runs")
+        .scan<'u', size_t>()
+        .default_value(size_t{10});
+    batch_command.add_argument("--min-time")
+        .help("minimal total time of the timed runs in seconds")
+        .scan<'g', double>()
+        .default_value(0.0);
+    batch_command.add_argument("--info")
+        .help("csv file to write the info about the graphs to");
+    batch_command.add_argument("--prefetch")
+        .help("parse the next graph on one more thread during the bench")
+        .default_value(false)
+        .implicit_value(true);
+
+    auto dynamic_command = argparse::ArgumentParser("dynamic");
+    dynamic_command.add_description("replays edge insertions and weight decreases on the mst maintained by link-cut trees and compares it with recomputing by kruskal");
+    dynamic_command.add_argument("graph")
+        .help("path to the file of the initial graph");
+    dynamic_command.add_argument("updates")
+        .help("file of \"u v w\" lines, an existing edge gets the lower weight w, any other is inserted");
+    dynamic_command.add_argument("--alg")
+        .help("algorithm computing the initial mst")
+        .default_value("kruskal");
+    dynamic_command.add_argument("--recompute-every")
+        .help("number of updates between the kruskal recomputations")
+        .scan<'u', size_t>()
+        .default_value(size_t{1000});
+    dynamic_command.add_argument("--threads")
+        .help("number of threads used by the parallel algorithms")
+        .scan<'u', size_t>()
+        .default_value(default_thread_count());
+
+    auto stream_command = argparse::ArgumentParser("stream");
+    stream_command.add_description("maintains the minimum spanning forest of a sliding window over a timestamped edge stream, prints its weight as csv");
+    stream_command.add_argument("stream")
+        .help("file with the \"n m\" header and \"u v w t\" lines ordered by the time t");
+    stream_command.add_argument("--window-edges")
+        .help("number of the latest edges in the window, 0 for no limit")
+        .scan<'u', size_t>()
+        .default_value(size_t{0});
+    stream_command.add_argument("--window-time")
+        .help("the window has the edges with time greater than the current time minus this, 0 for no limit")
+        .scan<'g', double>()
+        .default_value(0.0);
+    stream_command.add_argument("--report-every")
+        .help("number of edges between the printed rows")
+        .scan<'u', size_t>()
+        .default_value(size_t{1000});
+    stream_command.add_argument("--check")
+        .help("recompute the weight of every printed row by kruskal with union find, exits with 1 on difference")
+        .default_value(false)
+        .implicit_value(true);
 
     program.add_subparser(test_command);
     program.add_subparser(ls_command);
     program.add_subparser(info_command);
     program.add_subparser(bench_command);
+    program.add_subparser(convert_command);
+    program.add_subparser(verify_command);
+    program.add_subparser(batch_command);
+    program.add_subparser(dynamic_command);
+    program.add_subparser(stream_command);
 
     try {
         program.parse_args(argc, argv);
@@ -162,35 +676,166 @@ int main(int argc , char** argv) {
     if (program.is_subcommand_used(test_command)) {
         auto graph = test_command.get("graph");
         auto filter = test_command.get<std::vector<std::string>>("filter");
-        auto test_runner = TestRunner(graph, filter);
+        auto threads = test_command.get<size_t>("threads");
+        if (!valid_threads(threads)) {
+            return 1;
+        }
+        auto test_runner = TestRunner(graph, filter, threads);
         test_runner.run();
         std::cout << test_runner.res_as_json();
         return 0;
     }
     if (program.is_subcommand_used(ls_command)) {
-        auto g = parse_graph("graphs/xavierwoo/dtp_small/dtp_15_30_1.txt");
-        auto algs = get_algorithms(g);
-        for (auto& alg : algs) {
-            auto name = alg->name;
+        for (auto& [name, make] : get_algorithm_factories()) {
             std::cout << name << std::endl;
         }
     }
     if (program.is_subcommand_used(info_command)) {
         auto graph = info_command.get("graph");
+        auto start = Clc::now();
         auto g = parse_graph(graph);
+        auto load_time = std::chrono::duration<double>(Clc::now() - start).count();
+        auto file_mb = std::filesystem::file_size(graph) / (1024.0 * 1024.0);
         std::vector<std::pair<std::string, std::string>> info;
         info.emplace_back("connected", bool_to_str(g.is_connected()));
-        info.emplace_back("unique_weights", bool_to_str(all_edge_weights_unique(g.graph)));
-        info.emplace_back("vertices", std::to_string(boost::num_vertices(g.graph)));
-        info.emplace_back("edges", std::to_string(boost::num_edges(g.graph)));
+        info.emplace_back("unique_weights", bool_to_str(g.has_unique_weights()));
+        info.emplace_back("vertices", std::to_string(g.csr.num_vertices()));
+        info.emplace_back("edges", std::to_string(g.csr.num_edges()));
+        info.emplace_back("load_seconds", std::to_string(load_time));
+        info.emplace_back("load_mb_per_s", std::to_string(file_mb / load_time));
         std::cout << to_json(info);
     }
     if (program.is_subcommand_used(bench_command)) {
         auto graph = bench_command.get("graph");
         auto filter = bench_command.get<std::vector<std::string>>("filter");
-        auto bench_runner = BenchRunner(graph, filter);
+        auto threads = bench_command.get<size_t>("threads");
+        if (!valid_threads(threads)) {
+            return 1;
+        }
+        auto config = BenchConfig{};
+        config.warmup = bench_command.get<size_t>("warmup");
+        config.repetitions = std::max<size_t>(1, bench_command.get<size_t>("repetitions"));
+        config.min_seconds = bench_command.get<double>("min-time");
+        config.perf = bench_command.get<bool>("perf");
+        config.memory = bench_command.get<bool>("memory");
+        auto bench_runner = BenchRunner(graph, filter, threads, config);
         bench_runner.run();
         std::cout << bench_runner.res_as_json();
     }
+    if (program.is_subcommand_used(convert_command)) {
+        auto g = parse_graph(convert_command.get("graph"));
+        uint32_t flags = BinaryGraphDeduplicated;
+        if (g.is_connected()) {
+            flags |= BinaryGraphConnected;
+        }
+        if (g.has_unique_weights()) {
+            flags |= BinaryGraphUniqueWeights;
+        }
+        write_binary_graph(convert_command.get("output"), g.csr, flags);
+    }
+    if (program.is_subcommand_used(batch_command)) {
+        if (!valid_threads(batch_command.get<size_t>("threads"))) {
+            return 1;
+        }
+        auto config = BenchConfig{};
+        config.warmup = batch_command.get<size_t>("warmup");
+        config.repetitions = std::max<size_t>(1, batch_command.get<size_t>("repetitions"));
+        config.min_seconds = batch_command.get<double>("min-time");
+        auto info_file = std::optional<std::ofstream>{};
+        if (auto path = batch_command.present("info")) {
+            info_file.emplace(*path);
+        }
+        bool correct = run_batch(batch_inputs(batch_command.get("input")),
+                batch_command.get<std::vector<std::string>>("filter"),
+                batch_command.get<size_t>("threads"), config, batch_command.get<bool>("prefetch"),
+                std::cout, info_file ? &*info_file : nullptr);
+        return correct ? 0 : 1;
+    }
+    if (program.is_subcommand_used(dynamic_command)) {
+        auto threads = dynamic_command.get<size_t>("threads");
+        if (!valid_threads(threads)) {
+            return 1;
+        }
+        auto alg_name = dynamic_command.get("alg");
+        auto factories = get_algorithm_factories(threads);
+        auto it = std::find_if(factories.begin(), factories.end(), [&](auto const& f) { return f.first == alg_name; });
+        if (it == factories.end()) {
+            std::cerr << "unknown algorithm " << alg_name << std::endl;
+            return 1;
+        }
+        auto g = parse_graph(dynamic_command.get("graph"), threads);
+        auto updates = load_edge_updates(dynamic_command.get("updates"), g.csr.num_vertices());
+        auto ids = resolve_updates(g.csr, updates);
+        if (!ids) {
+            return 1;
+        }
+        auto recompute_every = std::max<size_t>(1, dynamic_command.get<size_t>("recompute-every"));
+        return replay_updates(g, updates, *ids, it->second, recompute_every, std::cout) ? 0 : 1;
+    }
+    if (program.is_subcommand_used(stream_command)) {
+        auto window_edges = stream_command.get<size_t>("window-edges");
+        auto window_time = stream_command.get<double>("window-time");
+        if (window_edges == 0 && window_time <= 0) {
+            std::cerr << "the window needs --window-edges or --window-time" << std::endl;
+            return 1;
+        }
+        auto stream = load_edge_stream(stream_command.get("stream"));
+        auto report_every = std::max<size_t>(1, stream_command.get<size_t>("report-every"));
+        bool correct = run_stream(stream, window_edges, window_time, report_every,
+                stream_command.get<bool>("check"), std::cout);
+        return correct ? 0 : 1;
+    }
+    if (program.is_subcommand_used(verify_command)) {
+        auto g = parse_graph(verify_command.get("graph"));
+        auto format = verify_command.get("format");
+        auto tree = std::vector<std::pair<VertexId, VertexId>>{};
+        if (format == "edges") {
+            tree = load_tree_edges(verify_command.get("tree"));
+        } else if (format == "pred") {
+            tree = load_predecessor_map(verify_command.get("tree"));
+        } else {
+            std::cerr << "unknown tree format " << format << std::endl;
+            return 1;
+        }
+        auto lca_name = verify_command.get("lca");
+        if (lca_name != "rmq" && lca_name != "offline") {
+            std::cerr << "unknown lca method " << lca_name << std::endl;
+            return 1;
+        }
+        auto lca_method = lca_name == "rmq" ? LCAMethod::rmq : LCAMethod::offline;
+        auto& csr = g.csr;
+        auto cert = verify_mst(csr, tree, lca_method);
+        auto edge_json = [](VertexId u, VertexId v) {
+            return "[" + std::to_string(u) + ", " + std::to_string(v) + "]";
+        };
+        auto max_violations = verify_command.get<size_t>("max-violations");
+        auto violating = std::string{"["};
+        for (size_t i = 0; i < std::min(max_violations, cert.violations.size()); i++) {
+            auto [e, path_max] = cert.violations[i];
+            auto edge = std::vector<std::pair<std::string, std::string>>{};
+            edge.emplace_back("edge", edge_json(csr.sources[e], csr.targets[e]));
+            edge.emplace_back("weight", std::to_string(csr.weights[e]));
+            edge.emplace_back("path_max", std::to_string(path_max));
+            violating += (i == 0 ? "\n" : ",\n") + to_json(edge);
+        }
+        violating += "]";
+        std::vector<std::pair<std::string, std::string>> res;
+        res.emplace_back("spanning_tree", bool_to_str(cert.is_spanning_tree()));
+        res.emplace_back("minimal", bool_to_str(cert.is_minimal()));
+        res.emplace_back("tree_weight", std::to_string(cert.tree_weight));
+        res.emplace_back("missing_edges", std::to_string(cert.missing_edges.size()));
+        if (!cert.missing_edges.empty()) {
+            auto [u, v] = cert.missing_edges.front();
+            res.emplace_back("first_missing_edge", edge_json(u, v));
+        }
+        if (cert.cycle_edge != NoEdge) {
+            res.emplace_back("cycle_edge", edge_json(csr.sources[cert.cycle_edge], csr.targets[cert.cycle_edge]));
+        }
+        res.emplace_back("spanning", bool_to_str(cert.spanning));
+        res.emplace_back("violations", std::to_string(cert.violations.size()));
+        res.emplace_back("violating_edges", violating);
+        std::cout << to_json(res);
+        return cert.is_minimal() ? 0 : 1;
+    }
     return 0;
 }
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+// Hardware and software counters of the calling thread read by
+// perf_event_open. Every counter is opened on its own, so the ones which the
+// cpu or the kernel (perf_event_paranoid, containers) doesn't allow are
+// just left out. When the kernel multiplexes the counters the values are
+// scaled by the time the counter was running.
+class PerfCounters {
+    public:
+    PerfCounters() {
+        add("cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        add("instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        add("l1d_misses", PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+                | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+        add("llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        add("branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        add("page_faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+    }
+
+    PerfCounters(PerfCounters const&) = delete;
+    PerfCounters& operator=(PerfCounters const&) = delete;
+
+    ~PerfCounters() {
+        for (auto& counter : counters) {
+            ::close(counter.fd);
+        }
+    }
+
+    bool available() const {
+        return !counters.empty();
+    }
+
+    void start() {
+        for (auto& counter : counters) {
+            ::ioctl(counter.fd, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(counter.fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    void stop() {
+        for (auto& counter : counters) {
+            ::ioctl(counter.fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+
+    // (name, value) of the counters since the last start, the counters whose
+    // read fails are left out
+    std::vector<std::pair<std::string, double>> read() const {
+        auto res = std::vector<std::pair<std::string, double>>{};
+        for (auto& counter : counters) {
+            uint64_t values[3] = {}; // value, time enabled, time running
+            if (::read(counter.fd, values, sizeof(values)) != sizeof(values)) {
+                continue;
+            }
+            double value = values[0];
+            if (values[2] != 0 && values[2] < values[1]) {
+                value *= static_cast<double>(values[1]) / values[2];
+            }
+            res.emplace_back(counter.name, value);
+        }
+        return res;
+    }
+
+    private:
+    struct Counter {
+        std::string name;
+        int fd;
+    };
+    std::vector<Counter> counters;
+
+    void add(std::string name, uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        // the threads started by the parallel algorithms are counted too,
+        // their counts are added when they exit
+        attr.inherit = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        // this thread on any cpu
+        int fd = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        if (fd >= 0) {
+            counters.push_back({std::move(name), fd});
+        }
+    }
+};
@@ -53,15 +53,38 @@ def collect_info(graphs):
         infos.append(info)
     return pd.DataFrame(infos)
 
-def collect_runtime(graphs):
+def collect_runtime(graphs, bench_args=[]):
     runtimes = []
     for graph in graphs:
-        res = run_and_collect_json([binary_path, 'bench', graph])
-        for name, time in res.items():
-            runtimes.append({'path' : graph, 'alg' : name, 'time' : time})
+        res = run_and_collect_json([binary_path, 'bench', graph] + bench_args)
+        for name, alg in res['algs'].items():
+            # time stays the mean in microseconds like in the older csvs
+            row = {'path' : graph, 'alg' : name, 'time' : alg['mean_ns'] / 1000, 'load_ns' : res['load_ns']}
+            row.update({key : value for key, value in alg.items() if key not in ('times_ns', 'perf', 'memory')})
+            row.update({f'perf_{key}' : value for key, value in alg.get('perf', {}).items()})
+            row.update({f'mem_{key}' : value for key, value in alg.get('memory', {}).items()})
+            runtimes.append(row)
     return pd.DataFrame(runtimes)
 
 
+def run_batch(graph_dir, outfile, prefetch=False, bench_args=[]):
+    # one mst-bench process for the whole directory, the info about the
+    # graphs goes next to the bench csv
+    info_file = os.path.splitext(outfile)[0] + '_info.csv'
+    prefetch_args = ['--prefetch'] if prefetch else []
+    with open(outfile, 'w') as f:
+        result = subprocess.run([binary_path, 'batch', graph_dir, '--info', info_file] + prefetch_args + bench_args, stdout=f)
+    if result.returncode != 0:
+        print('not all algorithms computed valid mst')
+
+
+def convert_graphs(graphs, out_dir):
+    os.makedirs(out_dir, exist_ok=True)
+    for graph in graphs:
+        name = os.path.splitext(os.path.basename(graph))[0] + '.bin'
+        subprocess.run([binary_path, 'convert', graph, os.path.join(out_dir, name)], check=True)
+
+
 def load_xavierwoo_dataset():
     graph_dir = "graphs/xavierwoo"
     graphs_file = os.path.join(graph_dir, "graphs.json")
@@ -77,9 +100,12 @@ def load_xavierwoo_dataset():
 
 def main():
     parser = argparse.ArgumentParser(description='Runner script for mst-bench')
-    parser.add_argument('action', help='[test|bench|info|check] what action to perform on graphs')
+    parser.add_argument('action', help='[test|bench|batch|info|convert] what action to perform on graphs')
     parser.add_argument('graph_dir', help='directory with graph files')
-    parser.add_argument('outfile', help='where to store csv', default='')
+    parser.add_argument('outfile', help='where to store csv (output directory for convert)', default='')
+    parser.add_argument('--perf', action='store_true', help='add hardware counters to the bench results')
+    parser.add_argument('--memory', action='store_true', help='add allocation counts and rss growth to the bench results')
+    parser.add_argument('--prefetch', action='store_true', help='batch parses the next graph during the bench of the current one')
 
     args = parser.parse_args()
 
@@ -98,8 +124,13 @@ def main():
         res = collect_info(df['path'])
         res.to_csv(args.outfile)
     elif args.action == 'bench':
-        res = collect_runtime(df['path']);
+        bench_args = (['--perf'] if args.perf else []) + (['--memory'] if args.memory else [])
+        res = collect_runtime(df['path'], bench_args);
         res.to_csv(args.outfile)
+    elif args.action == 'batch':
+        run_batch(args.graph_dir, args.outfile, args.prefetch)
+    elif args.action == 'convert':
+        convert_graphs(df['path'], args.outfile)
     else:
         print('not valid action')
 
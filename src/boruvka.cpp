@@ -1,158 +1,252 @@
 #include "mst_algorithms.h"
+#include "parallel.h"
+#include "union_find.h"
+
+#include <atomic>
+#include <numeric>
 
 MST Boruvka::compute_mst() {
-    GraphType* current = &g.graph;
-    GraphType tmp = GraphType();
-    auto mst = std::vector<std::pair<Vertex, Vertex>>{};
-    auto cur_to_old = std::optional<EdgeMap>{};
-    while (boost::num_vertices(*current) > 1) {
-        auto [edges, graph, map] = borůvka_step(*current, cur_to_old);
-        tmp = std::move(graph);
-        current = &tmp;
-        cur_to_old = std::move(map);
-        for (auto edge : edges) {
-            mst.push_back(edge);
+    auto& csr = g.csr;
+    auto mst = std::vector<EdgeId>{};
+    // edges of the contracted graph, the endpoints are the current components
+    // and the ids point to the original edges
+    auto src = std::vector<VertexId>(csr.sources.begin(), csr.sources.end());
+    auto dst = std::vector<VertexId>(csr.targets.begin(), csr.targets.end());
+    auto ids = std::vector<EdgeId>(csr.num_edges());
+    std::iota(ids.begin(), ids.end(), 0);
+    size_t vertexes = csr.num_vertices();
+
+    auto min_edge = std::vector<EdgeId>{};
+    auto set_to_new = std::vector<VertexId>{};
+    while (vertexes > 1 && !ids.empty()) {
+        min_edge.assign(vertexes, NoEdge);
+        for (size_t i = 0; i < ids.size(); i++) {
+            auto e = ids[i];
+            if (min_edge[src[i]] == NoEdge || csr.lighter(e, min_edge[src[i]])) {
+                min_edge[src[i]] = e;
+            }
+            if (min_edge[dst[i]] == NoEdge || csr.lighter(e, min_edge[dst[i]])) {
+                min_edge[dst[i]] = e;
+            }
         }
-    }
-    return mst;
-}
 
-std::tuple<EdgeSet, GraphType, EdgeMap>
-borůvka_step(GraphType& graph, std::optional<EdgeMap> cur_to_old) {
-    auto weight_map = get(boost::edge_weight, graph);
-    std::vector<Vertex> paren(boost::num_vertices(graph));
-    std::vector<size_t> rank(boost::num_vertices(graph));
-    boost::disjoint_sets dsets(make_iterator_property_map(
-                rank.begin(), get(boost::vertex_index, graph)), make_iterator_property_map(
-                paren.begin(), get(boost::vertex_index, graph)));
-    for (Vertex v : boost::make_iterator_range(boost::vertices(graph))) {
-        dsets.make_set(v);
-    }
-    std::unordered_set<std::pair<Vertex, Vertex>, PairHash<Vertex, Vertex>> min_edges{};
+        auto uf = UnionFind(vertexes);
+        // only the ids of the min edges are stored, so their endpoints in the
+        // current graph are found by scanning the edges again
+        for (size_t i = 0; i < ids.size(); i++) {
+            auto e = ids[i];
+            // the min edges form a forest, so the only way the endpoints are
+            // already joined is that the edge was chosen by both of them
+            if ((min_edge[src[i]] == e || min_edge[dst[i]] == e) && uf.unite(src[i], dst[i])) {
+                mst.push_back(e);
+            }
+        }
 
-    for (auto vertex : boost::make_iterator_range(boost::vertices(graph))) {
-        auto min_edge = std::optional<Edge>();
-        for (auto edge : boost::make_iterator_range(boost::out_edges(vertex, graph))) {
-            if (!min_edge.has_value() || weight_map[min_edge.value()] > weight_map[edge]) {
-                min_edge = edge;
+        // contract the components and drop the edges inside of them
+        set_to_new.assign(vertexes, std::numeric_limits<VertexId>::max());
+        size_t new_vertexes = 0;
+        for (Vertex v = 0; v < vertexes; v++) {
+            auto v_set = uf.find(v);
+            if (set_to_new[v_set] == std::numeric_limits<VertexId>::max()) {
+                set_to_new[v_set] = new_vertexes++;
             }
         }
-        if (min_edge.has_value()) {
-            auto dst = boost::target(min_edge.value(), graph);
-            auto first = std::min(vertex, dst);
-            auto second = std::max(vertex, dst);
-            if (cur_to_old.has_value()) {
-                min_edges.insert(cur_to_old.value()[std::make_pair(first, second)]);
-            } else {
-                min_edges.insert(std::make_pair(first, second));
+        size_t kept = 0;
+        for (size_t i = 0; i < ids.size(); i++) {
+            auto u = set_to_new[uf.find(src[i])];
+            auto v = set_to_new[uf.find(dst[i])];
+            if (u != v) {
+                src[kept] = u;
+                dst[kept] = v;
+                ids[kept++] = ids[i];
             }
-            dsets.union_set(vertex, boost::target(min_edge.value(), graph));
         }
+        src.resize(kept);
+        dst.resize(kept);
+        ids.resize(kept);
+        vertexes = new_vertexes;
     }
-    std::unordered_map<Vertex, Vertex> set_to_new{};
-    auto components = GraphType();
-    std::unordered_map<std::pair<Vertex, Vertex>, std::tuple<double, Vertex, Vertex>, PairHash<Vertex, Vertex>> components_edges{};
-
-    for (auto edge : boost::make_iterator_range(boost::edges(graph))) {
-        auto src = boost::source(edge, graph);
-        auto dst = boost::target(edge, graph);
-        auto src_set = dsets.find_set(src);
-        auto dst_set = dsets.find_set(dst);
-        if (src_set != dst_set) {
-            if (!set_to_new.contains(src_set)) {
-                set_to_new[src_set] = boost::add_vertex(components); 
+    return mst;
+}
+
+MST ParallelBoruvka::compute_mst() {
+    auto& csr = g.csr;
+    size_t vertexes = csr.num_vertices();
+    // the edges of the contracted graph, the weights are copied so the scans
+    // don't have to look them up by id, the relative order of the edges never
+    // changes, so comparing positions is the same as comparing ids
+    auto src = std::vector<VertexId>(csr.sources.begin(), csr.sources.end());
+    auto dst = std::vector<VertexId>(csr.targets.begin(), csr.targets.end());
+    auto weights = std::vector<double>(csr.weights.begin(), csr.weights.end());
+    auto ids = std::vector<EdgeId>(csr.num_edges());
+    std::iota(ids.begin(), ids.end(), 0);
+
+    auto mst = std::vector<EdgeId>(vertexes > 0 ? vertexes - 1 : 0);
+    auto mst_size = std::atomic<size_t>(0);
+
+    auto lighter = [&](EdgeId a, EdgeId b) {
+        return weights[a] < weights[b] || (weights[a] == weights[b] && a < b);
+    };
+    // min edges are stored as positions in the current edge arrays
+    auto write_min = [&](std::atomic<EdgeId>& slot, EdgeId pos) {
+        auto cur = slot.load(std::memory_order_relaxed);
+        while ((cur == NoEdge || lighter(pos, cur))
+                && !slot.compare_exchange_weak(cur, pos, std::memory_order_relaxed)) { }
+    };
+
+    auto counts = std::vector<size_t>(threads + 1);
+    auto prefix_sum = [&]() {
+        for (size_t t = 0; t < threads; t++) {
+            counts[t + 1] += counts[t];
+        }
+    };
+
+    auto new_ids = std::vector<VertexId>{};
+    auto next_src = std::vector<VertexId>{};
+    auto next_dst = std::vector<VertexId>{};
+    auto next_weights = std::vector<double>{};
+    auto next_ids = std::vector<EdgeId>{};
+    while (vertexes > 1 && !ids.empty()) {
+        size_t m = ids.size();
+        auto min_edge = std::vector<std::atomic<EdgeId>>(vertexes);
+        parallel_for(threads, vertexes, [&](size_t, size_t begin, size_t end) {
+            for (size_t u = begin; u < end; u++) {
+                min_edge[u].store(NoEdge, std::memory_order_relaxed);
             }
-            if (!set_to_new.contains(dst_set)) {
-                set_to_new[dst_set] = boost::add_vertex(components);
+        });
+        parallel_for(threads, m, [&](size_t, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                write_min(min_edge[src[i]], i);
+                write_min(min_edge[dst[i]], i);
             }
-            auto src_v = set_to_new[src_set];
-            auto dst_v = set_to_new[dst_set];
-            // the key has a specified order so (u, v) == (v, u)
-            auto first = std::min(src, dst);
-            auto second = std::max(src, dst);
-            auto key = std::make_pair(std::min(src_v, dst_v), std::max(src_v, dst_v));
-            if (!components_edges.contains(key) ||  weight_map[edge] < std::get<0>(components_edges[key])) {
-                if (cur_to_old.has_value()) {
-                    auto [old_src, old_dst] = cur_to_old.value()[std::make_pair(first, second)];
-                    components_edges[key] = {weight_map[edge], old_src, old_dst};
-                } else {
-                    components_edges[key] = {weight_map[edge], first, second};
+        });
+
+        // each min edge is added by one of its endpoints, the min edges form
+        // a forest so every union succeeds
+        auto sets = ConcurrentUnionFind(vertexes);
+        parallel_for(threads, vertexes, [&](size_t, size_t begin, size_t end) {
+            for (size_t u = begin; u < end; u++) {
+                auto pos = min_edge[u].load(std::memory_order_relaxed);
+                if (pos == NoEdge) {
+                    continue;
+                }
+                auto v = src[pos] == u ? dst[pos] : src[pos];
+                if (min_edge[v].load(std::memory_order_relaxed) == pos && v < u) {
+                    continue;
+                }
+                if (sets.unite(u, v)) {
+                    mst[mst_size.fetch_add(1, std::memory_order_relaxed)] = ids[pos];
                 }
             }
-        }
-    }
-    auto new_to_old = EdgeMap{};
-    for (auto [key, val] : components_edges) {
-        auto [src, dst] = key;
-        auto [weight, old_src, old_dst] = val;
-        // edge is key in components_edges set which prevents multiedges
-        boost::add_edge(src, dst, weight, components);
-        new_to_old[std::make_pair(src, dst)] = std::make_pair(old_src, old_dst);
-    }
+        });
 
-    return {std::move(min_edges), std::move(components), std::move(new_to_old)};
-}
+        // number the components densely, in the order of their roots
+        new_ids.resize(vertexes);
+        counts.assign(threads + 1, 0);
+        parallel_for(threads, vertexes, [&](size_t t, size_t begin, size_t end) {
+            size_t roots = 0;
+            for (size_t u = begin; u < end; u++) {
+                roots += sets.find(u) == u;
+            }
+            counts[t + 1] = roots;
+        });
+        prefix_sum();
+        size_t new_vertexes = counts[threads];
+        parallel_for(threads, vertexes, [&](size_t t, size_t begin, size_t end) {
+            auto next = counts[t];
+            for (size_t u = begin; u < end; u++) {
+                if (sets.find(u) == u) {
+                    new_ids[u] = next++;
+                }
+            }
+        });
 
-std::tuple<GraphType, std::unordered_set<double>> borůvka_step2(GraphType& graph) {
-    auto weight_map = get(boost::edge_weight, graph);
-    std::vector<Vertex> paren(boost::num_vertices(graph));
-    std::vector<size_t> rank(boost::num_vertices(graph));
-    boost::disjoint_sets dsets(make_iterator_property_map(
-                rank.begin(), get(boost::vertex_index, graph)), make_iterator_property_map(
-                paren.begin(), get(boost::vertex_index, graph)));
-    for (Vertex v : boost::make_iterator_range(boost::vertices(graph))) {
-        dsets.make_set(v);
+        // drop the edges inside of the components, each thread compacts its
+        // range to the offset given by the counts of the previous ranges
+        counts.assign(threads + 1, 0);
+        parallel_for(threads, m, [&](size_t t, size_t begin, size_t end) {
+            size_t crossing = 0;
+            for (size_t i = begin; i < end; i++) {
+                crossing += sets.find(src[i]) != sets.find(dst[i]);
+            }
+            counts[t + 1] = crossing;
+        });
+        prefix_sum();
+        size_t kept = counts[threads];
+        next_src.resize(kept);
+        next_dst.resize(kept);
+        next_weights.resize(kept);
+        next_ids.resize(kept);
+        parallel_for(threads, m, [&](size_t t, size_t begin, size_t end) {
+            auto next = counts[t];
+            for (size_t i = begin; i < end; i++) {
+                auto u = sets.find(src[i]);
+                auto v = sets.find(dst[i]);
+                if (u != v) {
+                    next_src[next] = new_ids[u];
+                    next_dst[next] = new_ids[v];
+                    next_weights[next] = weights[i];
+                    next_ids[next++] = ids[i];
+                }
+            }
+        });
+        src.swap(next_src);
+        dst.swap(next_dst);
+        weights.swap(next_weights);
+        ids.swap(next_ids);
+        vertexes = new_vertexes;
     }
-    std::unordered_set<double> min_edges{};
+    mst.resize(mst_size);
+    return mst;
+}
 
-    for (auto u : boost::make_iterator_range(boost::vertices(graph))) {
-        auto min_edge = std::optional<Edge>();
-        for (auto edge : boost::make_iterator_range(boost::out_edges(u, graph))) {
-            if (!min_edge.has_value() || weight_map[min_edge.value()] > weight_map[edge]) {
-                min_edge = edge;
-            }
+std::tuple<KKTGraph, std::pmr::vector<EdgeId>> borůvka_step2(KKTGraph const& graph, CSRGraph const& csr) {
+    auto* resource = graph.resource();
+    auto min_edge = std::pmr::vector<EdgeId>(graph.vertexes, NoEdge, resource);
+    for (size_t i = 0; i < graph.num_edges(); i++) {
+        auto e = graph.ids[i];
+        auto u = graph.sources[i];
+        auto v = graph.targets[i];
+        if (min_edge[u] == NoEdge || csr.lighter(e, min_edge[u])) {
+            min_edge[u] = e;
         }
-        if (min_edge.has_value()) {
-            auto v = boost::target(min_edge.value(), graph);
-            min_edges.insert(weight_map[min_edge.value()]);
-            dsets.union_set(u, v);
+        if (min_edge[v] == NoEdge || csr.lighter(e, min_edge[v])) {
+            min_edge[v] = e;
         }
     }
 
-    auto components = GraphType();
-    std::unordered_map<std::pair<Vertex, Vertex>, std::tuple<double, Vertex, Vertex>, PairHash<Vertex, Vertex>> components_edges{};
-    auto set_to_new = std::vector<Vertex>(boost::num_vertices(graph), graph.null_vertex());
-
-    for (auto edge : boost::make_iterator_range(boost::edges(graph))) {
-        auto src = boost::source(edge, graph);
-        auto dst = boost::target(edge, graph);
-        auto src_set = dsets.find_set(src);
-        auto dst_set = dsets.find_set(dst);
-        if (src_set != dst_set) {
-            if (set_to_new[src_set] == graph.null_vertex()) {
-                set_to_new[src_set] = boost::add_vertex(components); 
-            }
-            if (set_to_new[dst_set] == graph.null_vertex()) {
-                set_to_new[dst_set] = boost::add_vertex(components);
-            }
-            auto src_v = set_to_new[src_set];
-            auto dst_v = set_to_new[dst_set];
-            // the key has a specified order so (u, v) == (v, u)
-            auto first = std::min(src, dst);
-            auto second = std::max(src, dst);
-            auto key = std::make_pair(std::min(src_v, dst_v), std::max(src_v, dst_v));
-            if (!components_edges.contains(key) ||  weight_map[edge] < std::get<0>(components_edges[key])) {
-                components_edges[key] = {weight_map[edge], first, second};
-            }
+    auto uf = UnionFind(graph.vertexes, resource);
+    auto min_edges = std::pmr::vector<EdgeId>(resource);
+    for (size_t i = 0; i < graph.num_edges(); i++) {
+        auto e = graph.ids[i];
+        auto u = graph.sources[i];
+        auto v = graph.targets[i];
+        // the min edges form a forest, so the endpoints are joined only if
+        // the edge was already added from the other side
+        if ((min_edge[u] == e || min_edge[v] == e) && uf.unite(u, v)) {
+            min_edges.push_back(e);
         }
     }
-    for (auto [key, val] : components_edges) {
-        auto [src, dst] = key;
-        auto [weight, old_src, old_dst] = val;
-        // edge is key in components_edges set which prevents multiedges
-        boost::add_edge(src, dst, weight, components);
+
+    auto components = KKTGraph(resource);
+    auto set_to_new = std::pmr::vector<VertexId>(graph.vertexes, std::numeric_limits<VertexId>::max(), resource);
+    auto to_new = [&](Vertex u) {
+        auto u_set = uf.find(u);
+        if (set_to_new[u_set] == std::numeric_limits<VertexId>::max()) {
+            set_to_new[u_set] = components.vertexes++;
+        }
+        return set_to_new[u_set];
+    };
+    for (size_t i = 0; i < graph.num_edges(); i++) {
+        auto u = graph.sources[i];
+        auto v = graph.targets[i];
+        if (!uf.same_set(u, v)) {
+            // the multiedges are kept, removing them would need hashing
+            components.sources.push_back(to_new(u));
+            components.targets.push_back(to_new(v));
+            components.ids.push_back(graph.ids[i]);
+        }
     }
 
     return {std::move(components), std::move(min_edges)};
 }
-
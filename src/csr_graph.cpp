@@ -0,0 +1,62 @@
+#include "csr_graph.h"
+
+#include <cassert>
+#include <utility>
+
+namespace {
+
+struct CSRStorage {
+    std::vector<uint64_t> offsets;
+    std::vector<VertexId> neighbors;
+    std::vector<EdgeId> edge_ids;
+    std::vector<VertexId> sources;
+    std::vector<VertexId> targets;
+    std::vector<double> weights;
+};
+
+} // namespace
+
+CSRGraph build_csr(size_t vertexes, std::vector<VertexId> sources,
+        std::vector<VertexId> targets, std::vector<double> weights) {
+    assert(sources.size() == targets.size() && sources.size() == weights.size());
+    auto storage = std::make_shared<CSRStorage>();
+    auto& offsets = storage->offsets;
+    auto& neighbors = storage->neighbors;
+    auto& edge_ids = storage->edge_ids;
+    offsets.assign(vertexes + 1, 0);
+
+    // counting sort of the edge ends by vertex
+    for (size_t e = 0; e < sources.size(); e++) {
+        offsets[sources[e] + 1]++;
+        offsets[targets[e] + 1]++;
+    }
+    for (size_t u = 0; u < vertexes; u++) {
+        offsets[u + 1] += offsets[u];
+    }
+    neighbors.resize(offsets[vertexes]);
+    edge_ids.resize(offsets[vertexes]);
+    auto next = std::vector<uint64_t>(offsets.begin(), offsets.end() - 1);
+    for (size_t e = 0; e < sources.size(); e++) {
+        auto u = sources[e];
+        auto v = targets[e];
+        neighbors[next[u]] = v;
+        edge_ids[next[u]++] = e;
+        neighbors[next[v]] = u;
+        edge_ids[next[v]++] = e;
+    }
+
+    storage->sources = std::move(sources);
+    storage->targets = std::move(targets);
+    storage->weights = std::move(weights);
+
+    auto res = CSRGraph{};
+    res.vertexes = vertexes;
+    res.offsets = storage->offsets;
+    res.neighbors = storage->neighbors;
+    res.edge_ids = storage->edge_ids;
+    res.sources = storage->sources;
+    res.targets = storage->targets;
+    res.weights = storage->weights;
+    res.storage = std::move(storage);
+    return res;
+}
@@ -0,0 +1,98 @@
+#include "dynamic_mst.h"
+
+#include <stdexcept>
+
+DynamicMST::DynamicMST(CSRGraph const& graph, std::vector<EdgeId> const& mst)
+    : vertexes(graph.num_vertices())
+    , sources(graph.sources.begin(), graph.sources.end())
+    , targets(graph.targets.begin(), graph.targets.end())
+    , weights(graph.weights.begin(), graph.weights.end())
+    , tree(graph.num_edges(), false)
+    , forest(graph.num_vertices())
+    , tree_weight(0)
+    , swap_log()
+{
+    for (EdgeId e = 0; e < graph.num_edges(); e++) {
+        forest.add_node(weights[e]);
+    }
+    for (auto e : mst) {
+        if (tree[e] || forest.connected(sources[e], targets[e])) {
+            throw std::invalid_argument("the initial tree has a cycle");
+        }
+        link(e);
+    }
+}
+
+EdgeId DynamicMST::insert_edge(VertexId u, VertexId v, double weight) {
+    EdgeId e = weights.size();
+    sources.push_back(u);
+    targets.push_back(v);
+    weights.push_back(weight);
+    tree.push_back(false);
+    forest.add_node(weight);
+    offer(e);
+    return e;
+}
+
+void DynamicMST::decrease_weight(EdgeId e, double weight) {
+    if (weight > weights[e]) {
+        throw std::invalid_argument("the weight of an edge can only decrease");
+    }
+    if (tree[e]) {
+        // the tree edge only got lighter, so the forest stays minimal
+        tree_weight += weight - weights[e];
+        weights[e] = weight;
+        forest.set_weight(node(e), weight);
+        return;
+    }
+    weights[e] = weight;
+    forest.set_weight(node(e), weight);
+    offer(e);
+}
+
+std::vector<EdgeId> DynamicMST::tree_edges() const {
+    auto res = std::vector<EdgeId>{};
+    for (EdgeId e = 0; e < tree.size(); e++) {
+        if (tree[e]) {
+            res.push_back(e);
+        }
+    }
+    return res;
+}
+
+void DynamicMST::link(EdgeId e) {
+    forest.link(sources[e], node(e));
+    forest.link(node(e), targets[e]);
+    tree[e] = true;
+    tree_weight += weights[e];
+}
+
+void DynamicMST::cut(EdgeId e) {
+    forest.cut(sources[e], node(e));
+    forest.cut(node(e), targets[e]);
+    tree[e] = false;
+    tree_weight -= weights[e];
+}
+
+void DynamicMST::offer(EdgeId e) {
+    auto u = sources[e];
+    auto v = targets[e];
+    if (u == v) {
+        return;
+    }
+    // the path has an edge node between any two vertexes, and the vertex
+    // nodes weigh -inf, so the heaviest node is an edge
+    auto heaviest = forest.path_max(u, v);
+    if (heaviest == LinkCutTree::none) {
+        link(e);
+        swap_log.push_back({e, NoEdge});
+        return;
+    }
+    EdgeId replaced = heaviest - vertexes;
+    if (forest.weight_of(heaviest) > weights[e]
+            || (forest.weight_of(heaviest) == weights[e] && replaced > e)) {
+        cut(replaced);
+        link(e);
+        swap_log.push_back({e, replaced});
+    }
+}
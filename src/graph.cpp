@@ -5,8 +5,6 @@
 #include <boost/graph/kruskal_min_spanning_tree.hpp>
 #include <boost/graph/subgraph.hpp>
 #include <limits>
-#include <ranges>
-#include <unordered_set>
 
 
 void dump_as_dot(std::ostream& os, GraphType const& graph) {
@@ -18,35 +16,84 @@ void dump_as_dot(std::ostream& os, GraphType const& graph) {
             });
 }
 
+std::vector<std::tuple<Vertex, Vertex, double>> weighted_edges(GraphType const& graph) {
+    auto weight_map = get(boost::edge_weight, graph);
+    auto res = std::vector<std::tuple<Vertex, Vertex, double>>{};
+    res.reserve(boost::num_edges(graph));
+    for (auto edge : boost::make_iterator_range(boost::edges(graph))) {
+        res.push_back({boost::source(edge, graph), boost::target(edge, graph), weight_map[edge]});
+    }
+    return res;
+}
+
+GraphType& Graph::graph() {
+    if (!adjacency) {
+        adjacency = std::make_unique<GraphType>(csr.num_vertices());
+        for (EdgeId e = 0; e < csr.num_edges(); e++) {
+            boost::add_edge(csr.sources[e], csr.targets[e], csr.weights[e], *adjacency);
+        }
+    }
+    return *adjacency;
+}
+
 bool Graph::is_connected() {
-    std::vector<bool> visited(boost::num_vertices(graph), false);
-    boost::default_bfs_visitor vis{};
-    boost::breadth_first_search(graph, vertex(0, graph), visitor(vis)
-            .color_map(make_iterator_property_map(visited.begin(),
-                    get(boost::vertex_index, graph))));
-    return std::all_of(visited.begin(), visited.end(), std::identity());
+    if (!connected.has_value()) {
+        auto visited = std::vector<bool>(csr.num_vertices(), false);
+        auto stack = std::vector<VertexId>{};
+        size_t visited_cnt = 0;
+        if (csr.num_vertices() > 0) {
+            visited[0] = true;
+            stack.push_back(0);
+        }
+        while (!stack.empty()) {
+            auto u = stack.back();
+            stack.pop_back();
+            visited_cnt++;
+            for (size_t i = csr.offsets[u]; i < csr.offsets[u + 1]; i++) {
+                auto v = csr.neighbors[i];
+                if (!visited[v]) {
+                    visited[v] = true;
+                    stack.push_back(v);
+                }
+            }
+        }
+        connected = visited_cnt == csr.num_vertices();
+    }
+    return connected.value();
+}
+
+bool Graph::has_unique_weights() {
+    if (!unique_weights.has_value()) {
+        unique_weights = all_edge_weights_unique(csr);
+    }
+    return unique_weights.value();
 }
 
 double Graph::mst_weight() {
     std::vector<Edge> mst{};
-    boost::kruskal_minimum_spanning_tree(graph, std::back_inserter(mst));
+    boost::kruskal_minimum_spanning_tree(graph(), std::back_inserter(mst));
+    auto weights = weight_map();
     double res = 0;
     for (auto e : mst) {
-        res += weight_map[e];
+        res += weights[e];
     }
     return res;
 }
 
 double MSTAlgorithm::mst_weight(MST mst) {
     double res = 0;
-    if (std::holds_alternative<std::vector<Edge>>(mst)) {
+    if (std::holds_alternative<std::vector<EdgeId>>(mst)) {
+        for (auto e : std::get<std::vector<EdgeId>>(mst)) {
+            res += g.csr.weights[e];
+        }
+    } else if (std::holds_alternative<std::vector<Edge>>(mst)) {
+        auto weights = g.weight_map();
         for (auto e : std::get<std::vector<Edge>>(mst)) {
-            res += g.weight_map[e];
+            res += weights[e];
         }
     } else if (std::holds_alternative<std::vector<std::pair<Vertex, Vertex>>>(mst)) {
         for (auto [u, v] : std::get<std::vector<std::pair<Vertex, Vertex>>>(mst)) {
-            auto [edge, valid] = boost::edge(u, v, g.graph);
-            res += g.weight_map[edge];
+            res += g.csr.weights[g.csr.find_edge(u, v)];
         }
     } else if (std::holds_alternative<PredecessorMap>(mst)) {
         auto null_vertex = boost::graph_traits<GraphType>::null_vertex();
@@ -57,66 +104,76 @@ double MSTAlgorithm::mst_weight(MST mst) {
             if (v == null_vertex || v == u) {
                 continue;
             }
-            auto edge = boost::edge(u, v, g.graph).first;
-            res += g.weight_map[edge];
+            res += g.csr.weights[g.csr.find_edge(u, v)];
         }
     }
     return res;
 }
 
-Graph parse_graph(std::filesystem::path file) {
-    auto is = std::ifstream(file);
-    if (!is) {
-        throw std::runtime_error("failed to open file: " + file.string() + "\n");
-    }
-    std::string line;
-    if (!std::getline(is, line)) {
-        throw std::runtime_error(
-                "missing the first line declaring number of nodes and edges in " +
-                file.string() + "\n");
+std::vector<EdgeId> MSTAlgorithm::mst_edge_ids(MST mst) {
+    if (std::holds_alternative<std::vector<EdgeId>>(mst)) {
+        return std::get<std::vector<EdgeId>>(mst);
     }
-    auto tmp = collect(line | std::ranges::views::split(' '));
-    assert(tmp.size() == 2);
-    size_t vertexes = std::stoi(tmp[0]);
-    [[maybe_unused]] size_t edges = std::stoi(tmp[1]);
-
-    auto res = Graph(vertexes);
-
-    // to remove duplicates
-    auto inserted_edges = std::unordered_set<std::pair<Vertex, Vertex>, PairHash<Vertex, Vertex>>{};
-
-    while (std::getline(is, line)) {
-        auto tmp = collect(line | std::ranges::views::split(' '));
-        if (tmp.size() != 3) {
-            continue;
+    auto res = std::vector<EdgeId>{};
+    if (std::holds_alternative<std::vector<Edge>>(mst)) {
+        auto& graph = g.graph();
+        for (auto e : std::get<std::vector<Edge>>(mst)) {
+            res.push_back(g.csr.find_edge(boost::source(e, graph), boost::target(e, graph)));
+        }
+    } else if (std::holds_alternative<std::vector<std::pair<Vertex, Vertex>>>(mst)) {
+        for (auto [u, v] : std::get<std::vector<std::pair<Vertex, Vertex>>>(mst)) {
+            res.push_back(g.csr.find_edge(u, v));
         }
-        size_t src = std::stoi(tmp[0]);
-        size_t dst = std::stoi(tmp[1]);
-        double weight = std::stod(tmp[2]);
-        assert(src < vertexes);
-        assert(dst < vertexes);
-        auto in_order = ordered(src, dst);
-        if (!inserted_edges.contains(in_order)) {
-            inserted_edges.insert(in_order);
-            // set inserted edges is used to preven multi edges
-            boost::add_edge(src, dst, weight, res.graph);
+    } else if (std::holds_alternative<PredecessorMap>(mst)) {
+        auto null_vertex = boost::graph_traits<GraphType>::null_vertex();
+        auto& parent = std::get<PredecessorMap>(mst);
+        for (size_t u = 0; u < parent.size(); u++) {
+            auto v = parent[u];
+            if (v == null_vertex || v == u) {
+                continue;
+            }
+            res.push_back(g.csr.find_edge(u, v));
         }
     }
-
     return res;
 }
 
-bool all_edge_weights_unique(GraphType const& g) {
-    auto weight_map = get(boost::edge_weight, g);
-    std::unordered_set<double> weights{};
-    for (Edge e : boost::make_iterator_range(boost::edges(g))) {
-        auto weight = weight_map[e];
-        if (weights.contains(weight)) {
-            return false;
+Graph build_graph(EdgeList edges) {
+    return Graph(build_csr(edges.vertexes, std::move(edges.sources),
+            std::move(edges.targets), std::move(edges.weights)));
+}
+
+Graph parse_graph(std::filesystem::path file, size_t threads) {
+    if (is_binary_graph(file)) {
+        uint32_t flags = 0;
+        auto csr = open_binary_graph(file, flags);
+        if (!(flags & BinaryGraphDeduplicated)) {
+            // removing the multiedges may make the weights unique, only the
+            // connectivity is kept
+            auto edges = EdgeList{};
+            edges.vertexes = csr.num_vertices();
+            edges.sources.assign(csr.sources.begin(), csr.sources.end());
+            edges.targets.assign(csr.targets.begin(), csr.targets.end());
+            edges.weights.assign(csr.weights.begin(), csr.weights.end());
+            remove_multiedges(edges);
+            auto res = build_graph(std::move(edges));
+            res.connected = (flags & BinaryGraphConnected) != 0;
+            return res;
         }
-        weights.insert(weight);
+        auto res = Graph(std::move(csr));
+        res.connected = (flags & BinaryGraphConnected) != 0;
+        res.unique_weights = (flags & BinaryGraphUniqueWeights) != 0;
+        return res;
     }
-    return true;
+    auto edges = load_edge_list(file, threads);
+    remove_multiedges(edges);
+    return build_graph(std::move(edges));
+}
+
+bool all_edge_weights_unique(CSRGraph const& g) {
+    auto weights = std::vector<double>(g.weights.begin(), g.weights.end());
+    std::sort(weights.begin(), weights.end());
+    return std::adjacent_find(weights.begin(), weights.end()) == weights.end();
 }
 
 std::vector<Vertex> find_path(const GraphType& g, Vertex start, Vertex end) {
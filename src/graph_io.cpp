@@ -0,0 +1,425 @@
+#include "graph_io.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(std::filesystem::path file) : ptr(nullptr), length(0) {
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("failed to open file: " + file.string() + "\n");
+    }
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("failed to stat file: " + file.string() + "\n");
+    }
+    length = st.st_size;
+    if (length > 0) {
+        void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("failed to mmap file: " + file.string() + "\n");
+        }
+        ::madvise(mapped, length, MADV_SEQUENTIAL);
+        ptr = static_cast<const char*>(mapped);
+    }
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (ptr != nullptr) {
+        ::munmap(const_cast<char*>(ptr), length);
+    }
+}
+
+namespace {
+
+bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+const char* skip_blanks(const char* it, const char* end) {
+    while (it != end && is_blank(*it)) {
+        it++;
+    }
+    return it;
+}
+
+// parses one number and the blanks after it, returns nullptr on failure
+template<typename T>
+const char* parse_number(const char* it, const char* end, T& value) {
+    auto [ptr, ec] = std::from_chars(it, end, value);
+    if (ec != std::errc{} || ptr == it) {
+        return nullptr;
+    }
+    return skip_blanks(ptr, end);
+}
+
+const char* line_end(const char* it, const char* end) {
+    auto* newline = static_cast<const char*>(std::memchr(it, '\n', end - it));
+    return newline == nullptr ? end : newline;
+}
+
+// parses the lines in [it, end), lines which are not "u v w", or "u v w t"
+// when timed, are skipped, returns false if some edge has endpoint out of
+// range
+bool parse_edges(const char* it, const char* end, size_t vertexes, EdgeList& out, bool timed = false) {
+    bool in_range = true;
+    while (it < end) {
+        auto* eol = line_end(it, end);
+        size_t src = 0;
+        size_t dst = 0;
+        double weight = 0;
+        double time = 0;
+        auto* cur = skip_blanks(it, eol);
+        if ((cur = parse_number(cur, eol, src)) != nullptr
+                && (cur = parse_number(cur, eol, dst)) != nullptr
+                && (cur = parse_number(cur, eol, weight)) != nullptr
+                && (!timed || (cur = parse_number(cur, eol, time)) != nullptr)
+                && cur == eol) {
+            if (src < vertexes && dst < vertexes) {
+                out.sources.push_back(src);
+                out.targets.push_back(dst);
+                out.weights.push_back(weight);
+                if (timed) {
+                    out.timestamps.push_back(time);
+                }
+            } else {
+                in_range = false;
+            }
+        }
+        if (eol == end) {
+            break;
+        }
+        it = eol + 1;
+    }
+    return in_range;
+}
+
+EdgeList load_edges(std::filesystem::path file, size_t threads, bool timed) {
+    auto mapped = MappedFile(file);
+    const char* begin = mapped.data();
+    const char* end = begin + mapped.size();
+
+    auto* header_end = line_end(begin, end);
+    size_t vertexes = 0;
+    size_t declared_edges = 0;
+    auto* cur = skip_blanks(begin, header_end);
+    if (begin == end
+            || (cur = parse_number(cur, header_end, vertexes)) == nullptr
+            || (cur = parse_number(cur, header_end, declared_edges)) == nullptr) {
+        throw std::runtime_error(
+                "missing the first line declaring number of nodes and edges in " +
+                file.string() + "\n");
+    }
+    if (vertexes > std::numeric_limits<VertexId>::max()) {
+        throw std::runtime_error("too many vertexes in " + file.string() + "\n");
+    }
+    const char* body = header_end == end ? end : header_end + 1;
+
+    // chunk boundaries are moved to the start of the next line
+    size_t body_size = end - body;
+    threads = std::max<size_t>(1, std::min(threads, body_size / (1 << 16)));
+    auto starts = std::vector<const char*>{body};
+    for (size_t t = 1; t < threads; t++) {
+        auto* start = std::max(body + body_size * t / threads, starts.back());
+        start = line_end(start, end);
+        start = start == end ? end : start + 1;
+        starts.push_back(start);
+    }
+    starts.push_back(end);
+
+    auto chunks = std::vector<EdgeList>(threads);
+    auto in_range = std::atomic<bool>(true);
+    parallel_for(threads, threads, [&](size_t, size_t first, size_t last) {
+        for (size_t c = first; c < last; c++) {
+            size_t expected = declared_edges * (starts[c + 1] - starts[c]) / std::max<size_t>(1, body_size);
+            chunks[c].sources.reserve(expected);
+            chunks[c].targets.reserve(expected);
+            chunks[c].weights.reserve(expected);
+            if (!parse_edges(starts[c], starts[c + 1], vertexes, chunks[c], timed)) {
+                in_range = false;
+            }
+        }
+    });
+    if (!in_range) {
+        throw std::runtime_error("edge with endpoint out of range in " + file.string() + "\n");
+    }
+
+    // concatenate the chunks in the file order
+    auto offsets = std::vector<size_t>(threads + 1, 0);
+    for (size_t c = 0; c < threads; c++) {
+        offsets[c + 1] = offsets[c] + chunks[c].size();
+    }
+    auto res = EdgeList{};
+    res.vertexes = vertexes;
+    res.sources.resize(offsets[threads]);
+    res.targets.resize(offsets[threads]);
+    res.weights.resize(offsets[threads]);
+    res.timestamps.resize(timed ? offsets[threads] : 0);
+    parallel_for(threads, threads, [&](size_t, size_t first, size_t last) {
+        for (size_t c = first; c < last; c++) {
+            std::copy(chunks[c].sources.begin(), chunks[c].sources.end(), res.sources.begin() + offsets[c]);
+            std::copy(chunks[c].targets.begin(), chunks[c].targets.end(), res.targets.begin() + offsets[c]);
+            std::copy(chunks[c].weights.begin(), chunks[c].weights.end(), res.weights.begin() + offsets[c]);
+            std::copy(chunks[c].timestamps.begin(), chunks[c].timestamps.end(), res.timestamps.begin() + offsets[c]);
+            chunks[c] = EdgeList{};
+        }
+    });
+    return res;
+}
+
+} // namespace
+
+EdgeList load_edge_list(std::filesystem::path file, size_t threads) {
+    return load_edges(file, threads, false);
+}
+
+EdgeList load_edge_stream(std::filesystem::path file, size_t threads) {
+    return load_edges(file, threads, true);
+}
+
+EdgeList load_edge_updates(std::filesystem::path file, size_t vertexes) {
+    auto mapped = MappedFile(file);
+    auto res = EdgeList{};
+    res.vertexes = vertexes;
+    if (!parse_edges(mapped.data(), mapped.data() + mapped.size(), vertexes, res)) {
+        throw std::runtime_error("edge with endpoint out of range in " + file.string() + "\n");
+    }
+    return res;
+}
+
+void remove_multiedges(EdgeList& edges) {
+    // sorting by (ordered endpoints, position) puts the first occurrence of
+    // each edge at the start of its run
+    auto keys = std::vector<std::pair<uint64_t, EdgeId>>(edges.size());
+    for (size_t e = 0; e < edges.size(); e++) {
+        uint64_t u = std::min(edges.sources[e], edges.targets[e]);
+        uint64_t v = std::max(edges.sources[e], edges.targets[e]);
+        keys[e] = {(u << 32) | v, e};
+    }
+    std::sort(keys.begin(), keys.end());
+
+    auto keep = std::vector<bool>(edges.size(), false);
+    size_t kept = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (i == 0 || keys[i].first != keys[i - 1].first) {
+            keep[keys[i].second] = true;
+            kept++;
+        }
+    }
+    if (kept == edges.size()) {
+        return;
+    }
+
+    size_t next = 0;
+    for (size_t e = 0; e < edges.size(); e++) {
+        if (keep[e]) {
+            edges.sources[next] = edges.sources[e];
+            edges.targets[next] = edges.targets[e];
+            if (!edges.timestamps.empty()) {
+                edges.timestamps[next] = edges.timestamps[e];
+            }
+            edges.weights[next++] = edges.weights[e];
+        }
+    }
+    edges.sources.resize(kept);
+    edges.targets.resize(kept);
+    edges.weights.resize(kept);
+    edges.timestamps.resize(std::min(edges.timestamps.size(), kept));
+}
+
+std::vector<std::pair<VertexId, VertexId>> load_tree_edges(std::filesystem::path file) {
+    auto mapped = MappedFile(file);
+    const char* it = mapped.data();
+    const char* end = it + mapped.size();
+    auto res = std::vector<std::pair<VertexId, VertexId>>{};
+    while (it < end) {
+        auto* eol = line_end(it, end);
+        VertexId u = 0;
+        VertexId v = 0;
+        auto* cur = skip_blanks(it, eol);
+        if ((cur = parse_number(cur, eol, u)) != nullptr
+                && (cur = parse_number(cur, eol, v)) != nullptr) {
+            res.emplace_back(u, v);
+        }
+        it = eol + 1;
+    }
+    return res;
+}
+
+std::vector<std::pair<VertexId, VertexId>> load_predecessor_map(std::filesystem::path file) {
+    auto mapped = MappedFile(file);
+    const char* it = mapped.data();
+    const char* end = it + mapped.size();
+    auto res = std::vector<std::pair<VertexId, VertexId>>{};
+    VertexId u = 0;
+    for (size_t line = 1; it < end; line++) {
+        auto* eol = line_end(it, end);
+        auto* cur = skip_blanks(it, eol);
+        // blank lines are skipped, any other line has to be the parent
+        if (cur != eol) {
+            VertexId parent = 0;
+            if (parse_number(cur, eol, parent) != eol) {
+                throw std::runtime_error("invalid parent on line " + std::to_string(line) +
+                        " of " + file.string() + "\n");
+            }
+            if (parent != u) {
+                res.emplace_back(u, parent);
+            }
+            u++;
+        }
+        it = eol + 1;
+    }
+    return res;
+}
+
+bool is_binary_graph(std::filesystem::path file) {
+    auto is = std::ifstream(file, std::ios::binary);
+    char magic[sizeof(BinaryGraphMagic)] = {};
+    is.read(magic, sizeof(magic));
+    return is && std::equal(std::begin(magic), std::end(magic), std::begin(BinaryGraphMagic));
+}
+
+namespace {
+
+template<typename T>
+void write_array(std::ostream& os, std::span<const T> arr) {
+    os.write(reinterpret_cast<const char*>(arr.data()), arr.size_bytes());
+}
+
+template<typename T>
+std::span<const T> read_array(const char*& it, size_t size) {
+    auto res = std::span<const T>(reinterpret_cast<const T*>(it), size);
+    it += res.size_bytes();
+    return res;
+}
+
+// the offsets have to be a partition of the adjacency arrays and every id
+// in range, so a corrupted file can't make the algorithms read out of
+// bounds, and every edge has to be in the adjacency of both its endpoints
+// exactly once, so the algorithms walking the adjacency see the same graph
+// as the ones walking the edges
+void check_binary_graph(CSRGraph const& g, std::filesystem::path const& file) {
+    auto corrupted = [&](std::string const& what) {
+        return std::runtime_error("corrupted binary graph, " + what + ": " + file.string() + "\n");
+    };
+    size_t n = g.vertexes;
+    size_t m = g.weights.size();
+    if (g.offsets[0] != 0 || g.offsets[n] != 2 * m) {
+        throw corrupted("offsets don't span the adjacency");
+    }
+    for (size_t u = 0; u < n; u++) {
+        if (g.offsets[u] > g.offsets[u + 1]) {
+            throw corrupted("offsets decrease");
+        }
+    }
+    for (size_t e = 0; e < m; e++) {
+        if (g.sources[e] >= n || g.targets[e] >= n) {
+            throw corrupted("edge endpoint out of range");
+        }
+    }
+    // the adjacency has 2m slots, so when no edge is in more than two of
+    // them every edge is in exactly two
+    auto ends = std::vector<uint8_t>(m, 0);
+    for (size_t u = 0; u < n; u++) {
+        for (size_t i = g.offsets[u]; i < g.offsets[u + 1]; i++) {
+            auto v = g.neighbors[i];
+            auto e = g.edge_ids[i];
+            if (v >= n || e >= m) {
+                throw corrupted("adjacency out of range");
+            }
+            bool matches = (g.sources[e] == u && g.targets[e] == v)
+                || (g.sources[e] == v && g.targets[e] == u);
+            if (!matches || ++ends[e] > 2) {
+                throw corrupted("adjacency doesn't match the edges");
+            }
+        }
+    }
+}
+
+} // namespace
+
+void write_binary_graph(std::filesystem::path file, CSRGraph const& graph, uint32_t flags) {
+    auto os = std::ofstream(file, std::ios::binary | std::ios::trunc);
+    if (!os) {
+        throw std::runtime_error("failed to open file: " + file.string() + "\n");
+    }
+    auto header = BinaryGraphHeader{};
+    std::copy(std::begin(BinaryGraphMagic), std::end(BinaryGraphMagic), header.magic);
+    header.version = BinaryGraphVersion;
+    header.flags = flags;
+    header.vertexes = graph.num_vertices();
+    header.edges = graph.num_edges();
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    write_array(os, graph.weights);
+    write_array(os, graph.offsets);
+    write_array(os, graph.sources);
+    write_array(os, graph.targets);
+    write_array(os, graph.neighbors);
+    write_array(os, graph.edge_ids);
+    if (!os) {
+        throw std::runtime_error("failed to write file: " + file.string() + "\n");
+    }
+}
+
+CSRGraph open_binary_graph(std::filesystem::path file, uint32_t& flags) {
+    auto mapped = std::make_shared<MappedFile>(file);
+    auto header = BinaryGraphHeader{};
+    if (mapped->size() < sizeof(header)) {
+        throw std::runtime_error("truncated binary graph: " + file.string() + "\n");
+    }
+    std::memcpy(&header, mapped->data(), sizeof(header));
+    if (!std::equal(std::begin(BinaryGraphMagic), std::end(BinaryGraphMagic), header.magic)) {
+        throw std::runtime_error("not a binary graph: " + file.string() + "\n");
+    }
+    if (header.version != BinaryGraphVersion) {
+        throw std::runtime_error("unsupported binary graph version " +
+                std::to_string(header.version) + " in " + file.string() + "\n");
+    }
+    // the ids are 32 bit, larger counts would make the range checks useless
+    if (header.vertexes > std::numeric_limits<VertexId>::max()
+            || header.edges > std::numeric_limits<EdgeId>::max()) {
+        throw std::runtime_error("binary graph has too many vertexes or edges: " + file.string() + "\n");
+    }
+    size_t n = header.vertexes;
+    size_t m = header.edges;
+    // the header comes from the file, so the size must not wrap around to
+    // the size of the file
+    size_t expected = sizeof(header);
+    auto add_array = [&](size_t count, size_t element_size) {
+        size_t bytes = 0;
+        return !__builtin_mul_overflow(count, element_size, &bytes)
+            && !__builtin_add_overflow(expected, bytes, &expected);
+    };
+    if (!add_array(m, sizeof(double)) || !add_array(n + 1, sizeof(uint64_t))
+            || !add_array(2 * m, sizeof(VertexId)) || !add_array(4 * m, sizeof(uint32_t))
+            || mapped->size() != expected) {
+        throw std::runtime_error("binary graph has unexpected size: " + file.string() + "\n");
+    }
+
+    flags = header.flags;
+    auto res = CSRGraph{};
+    const char* it = mapped->data() + sizeof(header);
+    res.vertexes = n;
+    res.weights = read_array<double>(it, m);
+    res.offsets = read_array<uint64_t>(it, n + 1);
+    res.sources = read_array<VertexId>(it, m);
+    res.targets = read_array<VertexId>(it, m);
+    res.neighbors = read_array<VertexId>(it, 2 * m);
+    res.edge_ids = read_array<EdgeId>(it, 2 * m);
+    check_binary_graph(res, file);
+    res.storage = std::move(mapped);
+    return res;
+}
@@ -1,36 +1,94 @@
 #include "mst_algorithms.h"
+#include "union_find.h"
+
+#include <bit>
 
 MST Kruskal::compute_mst() {
-    auto mst = std::vector<Edge>{};
-    auto weight_map = boost::get(boost::edge_weight, g.graph);
-    size_t edges_in_mst = boost::num_vertices(g.graph) - 1;
+    auto& csr = g.csr;
+    auto mst = std::vector<EdgeId>{};
+    size_t edges_in_mst = csr.num_vertices() - 1;
 
     // sort the edges
-    std::vector<std::pair<Edge, double>> edges_with_weights;
-    for (auto e : boost::make_iterator_range(boost::edges(g.graph))) {
-        edges_with_weights.emplace_back(e, weight_map[e]);
+    std::vector<std::pair<double, EdgeId>> edges_with_weights;
+    edges_with_weights.reserve(csr.num_edges());
+    for (EdgeId e = 0; e < csr.num_edges(); e++) {
+        edges_with_weights.emplace_back(csr.weights[e], e);
     }
     std::sort(edges_with_weights.begin(), edges_with_weights.end(),
-            [](const std::pair<Edge, double>& a, const std::pair<Edge, double>& b) {
-            return a.second < b.second;
+            [](const std::pair<double, EdgeId>& a, const std::pair<double, EdgeId>& b) {
+            return a.first < b.first;
             });
 
-    // init union find
-    std::vector<Vertex> paren(boost::num_vertices(g.graph));
-    std::vector<size_t> rank(boost::num_vertices(g.graph));
-    boost::disjoint_sets dsets(make_iterator_property_map(
-                rank.begin(), get(boost::vertex_index, g.graph)), make_iterator_property_map(
-                paren.begin(), get(boost::vertex_index, g.graph)));
-    for (Vertex v : boost::make_iterator_range(boost::vertices(g.graph))) {
-        dsets.make_set(v);
+    auto uf = UnionFind(csr.num_vertices());
+
+    for (auto [weight, edge] : edges_with_weights) {
+        if (uf.unite(csr.sources[edge], csr.targets[edge])) {
+            mst.emplace_back(edge);
+        }
+        if (mst.size() == edges_in_mst) {
+            return mst;
+        }
     }
+    return mst;
+}
+
+// maps the double to unsigned integer with the same order, negative numbers
+// have all bits flipped and positive only the sign bit
+static uint64_t order_preserving_key(double weight) {
+    auto bits = std::bit_cast<uint64_t>(weight);
+    return (bits >> 63) ? ~bits : bits | (1ul << 63);
+}
 
-    for (auto [edge, weight] : edges_with_weights) {
-        auto u = dsets.find_set(edge.m_source);
-        auto v = dsets.find_set(edge.m_target);
-        if (u != v) {
+MST KruskalRadix::compute_mst() {
+    auto& csr = g.csr;
+    auto mst = std::vector<EdgeId>{};
+    size_t edges_in_mst = csr.num_vertices() - 1;
+    size_t m = csr.num_edges();
+
+    // sort the edges by LSD radix sort on bytes of the keys, the sort is
+    // stable so the edges with same weight stay ordered by id
+    constexpr size_t radix_bits = 8;
+    constexpr size_t buckets = 1ul << radix_bits;
+    constexpr size_t passes = 64 / radix_bits;
+    auto keys = std::vector<uint64_t>(m);
+    auto ids = std::vector<EdgeId>(m);
+    auto histograms = std::vector<size_t>(passes * buckets, 0);
+    for (EdgeId e = 0; e < m; e++) {
+        keys[e] = order_preserving_key(csr.weights[e]);
+        ids[e] = e;
+        for (size_t pass = 0; pass < passes; pass++) {
+            histograms[pass * buckets + ((keys[e] >> (pass * radix_bits)) & (buckets - 1))]++;
+        }
+    }
+    auto keys_tmp = std::vector<uint64_t>(m);
+    auto ids_tmp = std::vector<EdgeId>(m);
+    for (size_t pass = 0; pass < passes; pass++) {
+        auto* histogram = &histograms[pass * buckets];
+        size_t shift = pass * radix_bits;
+        // all keys have the same digit, this is common for the high bytes
+        if (m == 0 || histogram[(keys[0] >> shift) & (buckets - 1)] == m) {
+            continue;
+        }
+        size_t sum = 0;
+        for (size_t b = 0; b < buckets; b++) {
+            auto cnt = histogram[b];
+            histogram[b] = sum;
+            sum += cnt;
+        }
+        for (size_t i = 0; i < m; i++) {
+            auto pos = histogram[(keys[i] >> shift) & (buckets - 1)]++;
+            keys_tmp[pos] = keys[i];
+            ids_tmp[pos] = ids[i];
+        }
+        keys.swap(keys_tmp);
+        ids.swap(ids_tmp);
+    }
+
+    auto uf = UnionFind(csr.num_vertices());
+
+    for (auto edge : ids) {
+        if (uf.unite(csr.sources[edge], csr.targets[edge])) {
             mst.emplace_back(edge);
-            dsets.link(u, v);
         }
         if (mst.size() == edges_in_mst) {
             return mst;
@@ -38,3 +96,70 @@ MST Kruskal::compute_mst() {
     }
     return mst;
 }
+
+namespace {
+
+// (weight, id), the pair order is the total order of edges
+using WeightedEdge = std::pair<double, EdgeId>;
+
+struct FilterKruskalImpl {
+    // ranges at most this long are sorted as in plain Kruskal
+    static constexpr size_t threshold = 1024;
+
+    CSRGraph const& csr;
+    UnionFind& uf;
+    std::vector<EdgeId>& mst;
+    size_t edges_in_mst;
+
+    bool connected(EdgeId e) {
+        return uf.same_set(csr.sources[e], csr.targets[e]);
+    }
+
+    void kruskal(WeightedEdge* begin, WeightedEdge* end) {
+        std::sort(begin, end);
+        for (auto it = begin; it != end && mst.size() < edges_in_mst; it++) {
+            if (uf.unite(csr.sources[it->second], csr.targets[it->second])) {
+                mst.emplace_back(it->second);
+            }
+        }
+    }
+
+    void filter_kruskal(WeightedEdge* begin, WeightedEdge* end) {
+        if (mst.size() == edges_in_mst) {
+            return;
+        }
+        if (static_cast<size_t>(end - begin) <= threshold) {
+            kruskal(begin, end);
+            return;
+        }
+        // the median of three distinct edges is never the lightest one, so
+        // both halves are smaller than the range
+        auto a = *begin;
+        auto b = *(begin + (end - begin) / 2);
+        auto c = *(end - 1);
+        auto pivot = std::max(std::min(a, b), std::min(std::max(a, b), c));
+        auto mid = std::partition(begin, end, [&](const WeightedEdge& e) { return e < pivot; });
+        filter_kruskal(begin, mid);
+        // drop the heavy edges which would close a cycle before recursing
+        auto heavy_end = std::remove_if(mid, end, [&](const WeightedEdge& e) { return connected(e.second); });
+        filter_kruskal(mid, heavy_end);
+    }
+};
+
+} // namespace
+
+MST FilterKruskal::compute_mst() {
+    auto& csr = g.csr;
+    auto mst = std::vector<EdgeId>{};
+
+    std::vector<WeightedEdge> edges;
+    edges.reserve(csr.num_edges());
+    for (EdgeId e = 0; e < csr.num_edges(); e++) {
+        edges.emplace_back(csr.weights[e], e);
+    }
+
+    auto uf = UnionFind(csr.num_vertices());
+    auto impl = FilterKruskalImpl{csr, uf, mst, csr.num_vertices() - 1};
+    impl.filter_kruskal(edges.data(), edges.data() + edges.size());
+    return mst;
+}
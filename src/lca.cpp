@@ -4,44 +4,81 @@
 #include "lca.h"
 #include "utils.h"
 
-LCA::LCA(GraphType& graph, Vertex root)
-    : graph(graph)
-    , root(root)
-    , edges(boost::num_edges(graph))
+LCA::LCA(RootedTree tree, bool build_tables)
+    : tree(std::move(tree))
+    , root(this->tree.root)
+    , edges(this->tree.num_vertices() > 0 ? this->tree.num_vertices() - 1 : 0)
     , euler_size(2 * edges)
     , block_size(std::max(1ul, log2(euler_size) / 2))
     , block_cnt((euler_size + block_size - 1) / block_size)
-    , euler_tour()
-    , height(boost::num_vertices(graph), 0)
-    , first_visit(boost::num_vertices(graph), 0)
-    , sparse_table(block_cnt, std::vector<size_t>(log2(block_cnt) + 1))
-    , block_mask(block_cnt, 0)
-      , blocks(1 << (block_size - 1), std::vector(block_size, std::vector<size_t>(block_size)))
+    , euler_tour(resource())
+    , height(this->tree.depth.begin(), this->tree.depth.end(), resource())
+    , first_visit(this->tree.num_vertices(), 0, resource())
+    , euler_height(resource())
+    , sparse_table(resource())
+    , sparse_offset(log2(block_cnt) + 2, 0, resource())
+    , block_mask(block_cnt, 0, resource())
+    , blocks(resource())
+    , mask_stride(block_size * (block_size + 1) / 2)
 {
+    assert(euler_size < std::numeric_limits<uint32_t>::max());
+    assert(block_size <= 32);
+    for (size_t log_length = 0; log_length + 1 < sparse_offset.size(); log_length++) {
+        sparse_offset[log_length + 1] = sparse_offset[log_length] + block_cnt - (1ul << log_length) + 1;
+    }
     build_euler_tour();
-    build_sparse_table();
-    build_rmq();
-}
-
-Vertex LCA::parrent(Vertex u) {
-    if (u == root) {
-        return boost::graph_traits<GraphType>::null_vertex();
-    } else {
-        return euler_tour[first_visit[u] - 1];
+    if (build_tables) {
+        sparse_table.resize(sparse_offset.back());
+        blocks.resize((1ul << (block_size - 1)) * mask_stride);
+        build_sparse_table();
+        build_rmq();
     }
 }
 
 size_t LCA::lca(size_t u, size_t v) {
+    assert(!sparse_table.empty() || block_cnt == 0);
     auto l = first_visit[u];
     auto r = first_visit[v];
     if (l > r) {
         using std::swap;
         swap(l, r);
     }
-    size_t bl = l / block_size; 
+    return euler_tour[lca_of_positions(l, r)];
+}
+
+std::pmr::vector<Vertex> LCA::lca_many(std::span<std::pair<Vertex, Vertex> const> queries) {
+    // the first visits are gathered in one pass, the loads are independent
+    // so they are not waiting for each other
+    auto positions = std::pmr::vector<std::pair<uint32_t, uint32_t>>(queries.size(), resource());
+    for (size_t i = 0; i < queries.size(); i++) {
+        auto l = first_visit[queries[i].first];
+        auto r = first_visit[queries[i].second];
+        positions[i] = {std::min(l, r), std::max(l, r)};
+    }
+    // counting sort of the queries by the block of the left end
+    auto block_start = std::pmr::vector<uint32_t>(block_cnt + 1, 0, resource());
+    for (auto [l, r] : positions) {
+        block_start[l / block_size + 1]++;
+    }
+    for (size_t b = 0; b < block_cnt; b++) {
+        block_start[b + 1] += block_start[b];
+    }
+    auto order = std::pmr::vector<uint32_t>(queries.size(), resource());
+    for (size_t i = 0; i < queries.size(); i++) {
+        order[block_start[positions[i].first / block_size]++] = i;
+    }
+    auto res = std::pmr::vector<Vertex>(queries.size(), resource());
+    for (auto i : order) {
+        res[i] = euler_tour[lca_of_positions(positions[i].first, positions[i].second)];
+    }
+    return res;
+}
+
+size_t LCA::lca_of_positions(size_t l, size_t r) {
+    size_t bl = l / block_size;
     size_t br = r / block_size;
     if (bl == br) {
-        return euler_tour[lca_in_block(bl, l % block_size, r % block_size)];
+        return lca_in_block(bl, l % block_size, r % block_size);
     }
     size_t l_min = lca_in_block(bl, l % block_size, block_size - 1);
     size_t r_min = lca_in_block(br, 0, r % block_size);
@@ -50,48 +87,38 @@ size_t LCA::lca(size_t u, size_t v) {
         size_t half_log_len = log2(br - bl - 1);
         size_t first_half = bl + 1;
         size_t second_half = br - (1 << half_log_len);
-        l_min = sparse_table[first_half][half_log_len];
-        r_min = sparse_table[second_half][half_log_len];
-        min = min_by_height(min, min_by_height(l_min, r_min));
+        auto level = sparse_table.data() + sparse_offset[half_log_len];
+        min = min_by_height(min, min_by_height(level[first_half], level[second_half]));
     }
-    return euler_tour[min];
+    return min;
 }
 
 size_t LCA::lca_in_block(size_t block_index, size_t in_block_index, size_t interval_length) {
     auto block_offset = block_index * block_size;
-    return blocks[block_mask[block_index]][in_block_index][interval_length] + block_offset;
+    auto mask = block_mask[block_index];
+    return blocks[mask * mask_stride + triangle_index(in_block_index, interval_length)] + block_offset;
 }
 
 void LCA::build_euler_tour() {
-    euler_tour.reserve(euler_size);
-    using AdjIterator = boost::graph_traits<GraphType>::adjacency_iterator;
-    // cur, from, height, begin, end
-    std::vector<std::tuple<Vertex, Vertex, size_t, AdjIterator, AdjIterator>> stack{};
-    auto [begin, end] = boost::adjacent_vertices(root, graph);
-    stack.push_back({root, std::numeric_limits<Vertex>::max(), 0, begin, end});
+    euler_tour.reserve(euler_size + 1);
+    euler_height.reserve(euler_size + 1);
+    if (tree.num_vertices() == 0) {
+        return;
+    }
+    // vertex and the index of its next child in tree.children
+    auto stack = std::pmr::vector<std::pair<Vertex, uint32_t>>(resource());
+    stack.push_back({root, tree.child_offset[root]});
     while (!stack.empty()) {
-        auto [cur, prev, h, begin, end] = stack.back();
-        stack.pop_back();
-        if (boost::adjacent_vertices(cur, graph).first == begin) {
-            first_visit[cur] = euler_tour.size();
-            height[cur] = h;
-        }
+        auto& [cur, next_child] = stack.back();
         euler_tour.push_back(cur);
-        if (begin == end) {
+        euler_height.push_back(height[cur]);
+        if (next_child == tree.child_offset[cur + 1]) {
+            stack.pop_back();
             continue;
         }
-        auto next = *begin;
-        ++begin;
-        if (next == prev) {
-            if (begin == end) {
-                continue;
-            }
-            next = *begin;
-            begin++;
-        }
-        stack.push_back({cur, prev, h, begin, end});
-        auto [next_begin, next_end] = boost::adjacent_vertices(next, graph);
-        stack.push_back({next, cur, h + 1, next_begin, next_end});
+        auto child = tree.children[next_child++];
+        first_visit[child] = euler_tour.size();
+        stack.push_back({child, tree.child_offset[child]});
     }
 }
 
@@ -102,33 +129,29 @@ void LCA::build_sparse_table() {
             cur_block++;
         }
         // find the minimum of each block
-        if (block_index == 0 || (min_by_height(i, sparse_table[cur_block][0]) == i)) {
-            sparse_table[cur_block][0] = i;
+        if (block_index == 0 || (min_by_height(i, sparse_table[cur_block]) == i)) {
+            sparse_table[cur_block] = i;
         }
         // building mask for the current block
         // testing if height of current possition is prev + 1 if true add +
         if (block_index > 0 && (min_by_height(i - 1, i) == i - 1)) {
             size_t bit_index = block_index - 1;
-            block_mask[cur_block] |= 1 << bit_index; // marking as +
+            block_mask[cur_block] |= 1u << bit_index; // marking as +
         }
     }
     // compute mins for squares of blocks
-    for (size_t log_length = 1; log_length <= log2(block_cnt); log_length++) {
-        size_t prev_length = log_length - 1;
-        for (size_t i = 0; i < block_cnt; i++) {
-            size_t next_block = i + (1 << prev_length);
-            size_t cur_min = sparse_table[i][prev_length];
-            if (next_block >= block_cnt) {
-                sparse_table[i][log_length] = cur_min;
-            } else {
-                sparse_table[i][log_length] = min_by_height(cur_min, sparse_table[next_block][prev_length]);
-            }
+    for (size_t log_length = 1; log_length + 1 < sparse_offset.size(); log_length++) {
+        auto prev = sparse_table.data() + sparse_offset[log_length - 1];
+        auto cur = sparse_table.data() + sparse_offset[log_length];
+        size_t half = 1ul << (log_length - 1);
+        for (size_t i = 0; i < sparse_offset[log_length + 1] - sparse_offset[log_length]; i++) {
+            cur[i] = min_by_height(prev[i], prev[i + half]);
         }
     }
 }
 
 void LCA::build_rmq() {
-    auto computed = std::vector<bool>(blocks.size(), false);
+    auto computed = std::pmr::vector<bool>(1ul << (block_size - 1), false, resource());
     for (size_t cur_block = 0; cur_block < block_cnt; cur_block++) {
         auto mask = block_mask[cur_block];
         if (computed[mask]) {
@@ -136,20 +159,19 @@ void LCA::build_rmq() {
         }
         computed[mask] = true;
         auto block_offset = cur_block * block_size;
-        // compute the min of each sub interval 
+        auto triangle = blocks.data() + mask * mask_stride;
+        // compute the min of each sub interval
         assert(mask < (1ul<<(block_size - 1)));
         for (size_t l = 0; l < block_size; l++) {
-            assert(l < block_size);
-            blocks[mask][l][l] = l; // the min of [l, l]
-                                    // compute min for all interval sizes in block
+            triangle[triangle_index(l, l)] = l; // the min of [l, l]
+            // compute min for all interval sizes in block
             for (size_t r = l + 1; r < block_size; r++) {
-                assert(r < block_size);
-                blocks[mask][l][r] = blocks[mask][l][r - 1];
-                auto cur_min_pos = block_offset + blocks[mask][l][r];
+                size_t cur_min = triangle[triangle_index(l, r - 1)];
                 auto orig_pos = r + block_offset;
                 if (orig_pos < euler_size) {
-                    blocks[mask][l][r] = min_by_height(cur_min_pos, orig_pos) - block_offset;
+                    cur_min = min_by_height(block_offset + cur_min, orig_pos) - block_offset;
                 }
+                triangle[triangle_index(l, r)] = cur_min;
             }
         }
     }
@@ -158,7 +180,7 @@ void LCA::build_rmq() {
 std::vector<Vertex> LCA::leafs() {
     auto res = std::vector<Vertex>{};
     auto leaf_depth = max_depth();
-    for (auto v : boost::make_iterator_range(boost::vertices(graph))) {
+    for (Vertex v = 0; v < tree.num_vertices(); v++) {
         if (depth(v) == leaf_depth) {
             res.emplace_back(v);
         }
@@ -168,7 +190,8 @@ std::vector<Vertex> LCA::leafs() {
 
 std::string LCA::dump() {
     auto res = std::string{};
-    dump_as_dot(std::cout, graph);
+    res += "parents: ";
+    res += dump_vector(tree.parent);
     res += "graph with root: " + std::to_string(root) + '\n';
     res += "edges: " + std::to_string(edges) + '\n';
     res += "euler_size: " + std::to_string(euler_size) + '\n';
@@ -222,7 +245,7 @@ std::string LCA::dump_block(size_t block_index) {
     for (size_t l = 0; l < block_size; l++) {
         res += "min [" + std::to_string(l) + ", ...]\n";
         for (size_t r = l; r < block_size; r++) {
-            res += std::to_string(blocks[mask][l][r]) + " ";
+            res += std::to_string(blocks[mask * mask_stride + triangle_index(l, r)]) + " ";
         }
         res += '\n';
     }
@@ -231,14 +254,13 @@ std::string LCA::dump_block(size_t block_index) {
 
 std::string LCA::dump_sparse_table() {
     auto res = std::string{};
-    for (size_t log_length = 0; log_length <= log2(block_cnt); log_length++) {
+    for (size_t log_length = 0; log_length + 1 < sparse_offset.size(); log_length++) {
         res += "min of " + std::to_string(log_length) + " blocks: ";
-        for (size_t i = 0; i < block_cnt; i++) {
-            auto cur_min = sparse_table[i][log_length];
+        for (size_t i = sparse_offset[log_length]; i < sparse_offset[log_length + 1]; i++) {
+            auto cur_min = sparse_table[i];
             res += std::to_string(cur_min) + "(" + std::to_string(euler_tour[cur_min]) + "), ";
         }
         res += '\n';
     }
     return res;
 }
-
@@ -0,0 +1,101 @@
+#include "mst_verify.h"
+#include "union_find.h"
+
+#include <limits>
+
+std::pmr::vector<double> forest_path_maxima(size_t vertexes,
+        std::span<std::tuple<Vertex, Vertex, double> const> forest,
+        std::span<std::tuple<Vertex, Vertex, double> const> queries,
+        LCAMethod lca_method, std::pmr::memory_resource* resource) {
+    auto uf = UnionFind(vertexes, resource);
+    for (auto [u, v, weight] : forest) {
+        uf.unite(u, v);
+    }
+    // the queries with endpoints in one tree, the others have no path
+    auto res = std::pmr::vector<double>(queries.size(), std::numeric_limits<double>::infinity(), resource);
+    auto tree_queries = std::pmr::vector<std::tuple<Vertex, Vertex, double>>(resource);
+    auto query_index = std::pmr::vector<size_t>(resource);
+    for (size_t i = 0; i < queries.size(); i++) {
+        auto [u, v, weight] = queries[i];
+        if (u == v) {
+            // the path of a loop has no edges
+            res[i] = -std::numeric_limits<double>::infinity();
+        } else if (uf.same_set(u, v)) {
+            tree_queries.push_back(queries[i]);
+            query_index.push_back(i);
+        }
+    }
+    if (tree_queries.empty()) {
+        return res;
+    }
+
+    // all trees are joined under a virtual root by edges lighter than any
+    // other, the path between two vertexes of one tree doesn't go through
+    // the root, so a single verification answers the queries of all trees
+    auto tree = std::pmr::vector<std::tuple<Vertex, Vertex, double>>(forest.begin(), forest.end(), resource);
+    tree.reserve(forest.size() + vertexes);
+    Vertex virtual_root = vertexes;
+    for (Vertex u = 0; u < vertexes; u++) {
+        if (uf.find(u) == u) {
+            tree.push_back({virtual_root, u, -std::numeric_limits<double>::infinity()});
+        }
+    }
+    auto mv = MSTVerify(vertexes + 1, tree, std::move(tree_queries), lca_method);
+    auto maxima = mv.path_maxima();
+    for (size_t q = 0; q < maxima.size(); q++) {
+        res[query_index[q]] = maxima[q];
+    }
+    return res;
+}
+
+MSTCertificate verify_mst(CSRGraph const& csr, std::vector<std::pair<VertexId, VertexId>> const& tree,
+        LCAMethod lca_method) {
+    auto res = MSTCertificate{};
+    auto in_tree = std::vector<bool>(csr.num_edges(), false);
+    auto uf = UnionFind(csr.num_vertices());
+    for (auto [u, v] : tree) {
+        auto e = u < csr.num_vertices() && v < csr.num_vertices() ? csr.find_edge(u, v) : NoEdge;
+        if (e == NoEdge) {
+            res.missing_edges.emplace_back(u, v);
+            continue;
+        }
+        // also catches the same edge listed twice
+        if (!uf.unite(u, v)) {
+            if (res.cycle_edge == NoEdge) {
+                res.cycle_edge = e;
+            }
+            continue;
+        }
+        in_tree[e] = true;
+        res.tree_weight += csr.weights[e];
+    }
+
+    auto forest = std::vector<std::tuple<Vertex, Vertex, double>>{};
+    auto queries = std::vector<std::tuple<Vertex, Vertex, double>>{};
+    auto query_edges = std::vector<EdgeId>{};
+    for (EdgeId e = 0; e < csr.num_edges(); e++) {
+        auto u = csr.sources[e];
+        auto v = csr.targets[e];
+        if (in_tree[e]) {
+            forest.push_back({u, v, csr.weights[e]});
+        } else if (!uf.same_set(u, v)) {
+            res.spanning = false;
+        } else if (u != v) {
+            queries.push_back({u, v, csr.weights[e]});
+            query_edges.push_back(e);
+        }
+    }
+    if (!res.is_spanning_tree()) {
+        return res;
+    }
+
+    // cycle property, no non-tree edge can be lighter than the tree path
+    // between its endpoints
+    auto maxima = forest_path_maxima(csr.num_vertices(), forest, queries, lca_method);
+    for (size_t i = 0; i < queries.size(); i++) {
+        if (std::get<2>(queries[i]) < maxima[i]) {
+            res.violations.emplace_back(query_edges[i], maxima[i]);
+        }
+    }
+    return res;
+}
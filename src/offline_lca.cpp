@@ -0,0 +1,53 @@
+#include "offline_lca.h"
+#include "union_find.h"
+
+#include <cstdint>
+#include <limits>
+#include <numeric>
+
+std::pmr::vector<Vertex> offline_lca(LCA const& tour, std::span<std::pair<Vertex, Vertex> const> queries) {
+    constexpr auto none = std::numeric_limits<uint32_t>::max();
+    auto n = tour.height.size();
+    // query i is in the lists of both its endpoints as 2i and 2i + 1
+    auto* resource = tour.resource();
+    auto first_query = std::pmr::vector<uint32_t>(n, none, resource);
+    auto next_query = std::pmr::vector<uint32_t>(2 * queries.size(), resource);
+    for (size_t i = 0; i < queries.size(); i++) {
+        auto [u, v] = queries[i];
+        next_query[2 * i] = first_query[u];
+        first_query[u] = 2 * i;
+        next_query[2 * i + 1] = first_query[v];
+        first_query[v] = 2 * i + 1;
+    }
+
+    auto uf = UnionFind(n, resource);
+    // the vertex on the current dfs path to which the set was united
+    auto ancestor = std::pmr::vector<Vertex>(n, resource);
+    std::iota(ancestor.begin(), ancestor.end(), 0);
+    auto finished = std::pmr::vector<bool>(n, false, resource);
+    auto res = std::pmr::vector<Vertex>(queries.size(), resource);
+
+    auto finish = [&](Vertex u) {
+        finished[u] = true;
+        for (auto q = first_query[u]; q != none; q = next_query[q]) {
+            auto other = q % 2 ? queries[q / 2].first : queries[q / 2].second;
+            if (finished[other]) {
+                res[q / 2] = ancestor[uf.find(other)];
+            }
+        }
+    };
+    auto& euler_tour = tour.euler_tour;
+    for (size_t i = 1; i < euler_tour.size(); i++) {
+        if (tour.euler_height[i] < tour.euler_height[i - 1]) {
+            auto prev = euler_tour[i - 1];
+            auto cur = euler_tour[i];
+            finish(prev);
+            uf.unite(cur, prev);
+            ancestor[uf.find(cur)] = cur;
+        }
+    }
+    if (!euler_tour.empty()) {
+        finish(euler_tour.back());
+    }
+    return res;
+}
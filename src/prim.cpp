@@ -1,8 +1,13 @@
 #include "mst_algorithms.h"
+#include "bucket_queue.h"
+#include "dary_heap.h"
 #include <boost/graph/graph_traits.hpp>
 #include <boost/graph/subgraph.hpp>
 #include <boost/range/iterator_range_core.hpp>
 #include <boost/heap/fibonacci_heap.hpp>
+#include <algorithm>
+#include <bit>
+#include <cmath>
 #include <limits>
 #include <queue>
 
@@ -16,17 +21,16 @@ struct Node {
 };
 
 MST PrimBinHeap::compute_mst() {
-    auto& graph = g.graph;
-    auto weight_map = g.weight_map;
+    auto& csr = g.csr;
     auto null_vertex = boost::graph_traits<GraphType>::null_vertex();
-    auto pred = std::vector<Vertex>(boost::num_vertices(graph), null_vertex);
-    auto min_dist = std::vector<double>(boost::num_vertices(graph), std::numeric_limits<double>::infinity());
-    auto in_mst = std::vector<bool>(boost::num_vertices(graph), false);
+    auto pred = std::vector<Vertex>(csr.num_vertices(), null_vertex);
+    auto min_dist = std::vector<double>(csr.num_vertices(), std::numeric_limits<double>::infinity());
+    auto in_mst = std::vector<bool>(csr.num_vertices(), false);
 
 
     auto queue = std::priority_queue<Node, std::vector<Node>, std::greater<>>{};
 
-    auto start = *boost::vertices(graph).first;
+    Vertex start = 0;
 
     min_dist[start] = 0;
     queue.emplace(start, 0.0);
@@ -37,9 +41,9 @@ MST PrimBinHeap::compute_mst() {
 
         in_mst[u] = true;
 
-        for (auto edge : boost::make_iterator_range(boost::out_edges(u, graph))) {
-            auto v = boost::target(edge, graph);
-            auto weight = weight_map[edge];
+        for (size_t i = csr.offsets[u]; i < csr.offsets[u + 1]; i++) {
+            auto v = csr.neighbors[i];
+            auto weight = csr.weights[csr.edge_ids[i]];
             if (!in_mst[v] && weight < min_dist[v]) {
                 min_dist[v] = weight;
                 pred[v] = u;
@@ -52,19 +56,18 @@ MST PrimBinHeap::compute_mst() {
 }
 
 MST PrimFibHeap::compute_mst() {
-    auto& graph = g.graph;
-    auto weight_map = g.weight_map;
+    auto& csr = g.csr;
     auto null_vertex = boost::graph_traits<GraphType>::null_vertex();
-    auto pred = std::vector<Vertex>(boost::num_vertices(graph), null_vertex);
-    auto min_dist = std::vector<double>(boost::num_vertices(graph), std::numeric_limits<double>::infinity());
-    auto in_mst = std::vector<bool>(boost::num_vertices(graph), false);
+    auto pred = std::vector<Vertex>(csr.num_vertices(), null_vertex);
+    auto min_dist = std::vector<double>(csr.num_vertices(), std::numeric_limits<double>::infinity());
+    auto in_mst = std::vector<bool>(csr.num_vertices(), false);
 
-    auto start = *boost::vertices(graph).first;
+    Vertex start = 0;
 
     using FibHeap = boost::heap::fibonacci_heap<Node, boost::heap::compare<std::greater<>>>;
     using FibHandle = FibHeap::handle_type;
     auto heap = FibHeap{};
-    auto handles = std::vector<std::optional<FibHandle>>(boost::num_vertices(graph));
+    auto handles = std::vector<std::optional<FibHandle>>(csr.num_vertices());
 
     min_dist[start] = 0;
     handles[start] = heap.push({start, 0.0});
@@ -75,9 +78,9 @@ MST PrimFibHeap::compute_mst() {
 
         in_mst[u] = true;
 
-        for (auto edge : boost::make_iterator_range(boost::out_edges(u, graph))) {
-            auto v = boost::target(edge, graph);
-            double weight = weight_map[edge];
+        for (size_t i = csr.offsets[u]; i < csr.offsets[u + 1]; i++) {
+            auto v = csr.neighbors[i];
+            double weight = csr.weights[csr.edge_ids[i]];
 
             if (!in_mst[v] && weight < min_dist[v]) {
                 min_dist[v] = weight;
@@ -94,3 +97,90 @@ MST PrimFibHeap::compute_mst() {
 
     return pred;
 }
+
+// Prim over queue with decrease key, returns the ids of the mst edges
+template<typename Queue>
+static std::vector<EdgeId> prim_with_queue(CSRGraph const& csr, Queue& queue) {
+    auto mst = std::vector<EdgeId>{};
+    auto pred_edge = std::vector<EdgeId>(csr.num_vertices(), NoEdge);
+    auto min_dist = std::vector<double>(csr.num_vertices(), std::numeric_limits<double>::infinity());
+    auto in_mst = std::vector<bool>(csr.num_vertices(), false);
+
+    VertexId start = 0;
+
+    if (csr.num_vertices() > 0) {
+        mst.reserve(csr.num_vertices() - 1);
+        queue.push_or_decrease(start, 0.0);
+    }
+
+    while (!queue.empty()) {
+        auto u = queue.pop().second;
+        in_mst[u] = true;
+        if (pred_edge[u] != NoEdge) {
+            mst.push_back(pred_edge[u]);
+        }
+
+        for (size_t i = csr.offsets[u]; i < csr.offsets[u + 1]; i++) {
+            auto v = csr.neighbors[i];
+            auto e = csr.edge_ids[i];
+            auto weight = csr.weights[e];
+            if (!in_mst[v] && weight < min_dist[v]) {
+                min_dist[v] = weight;
+                pred_edge[v] = e;
+                queue.push_or_decrease(v, weight);
+            }
+        }
+    }
+
+    return mst;
+}
+
+template<size_t D>
+MST PrimDaryHeap<D>::compute_mst() {
+    auto heap = IndexedDaryHeap<D, double>(g.csr.num_vertices());
+    return prim_with_queue(g.csr, heap);
+}
+
+template class PrimDaryHeap<2>;
+template class PrimDaryHeap<4>;
+template class PrimDaryHeap<8>;
+
+PrimBucketQueue::PrimBucketQueue(Graph &g)
+    : MSTAlgorithm(g, "prim_bucket_queue")
+    , min_weight(0)
+    , max_weight(0)
+    , buckets(0)
+    , fallback(true)
+{
+    auto& csr = g.csr;
+    if (csr.num_edges() == 0) {
+        return;
+    }
+    auto [min_it, max_it] = std::minmax_element(csr.weights.begin(), csr.weights.end());
+    min_weight = *min_it;
+    max_weight = *max_it;
+    if (!std::isfinite(min_weight) || !std::isfinite(max_weight) || min_weight == max_weight) {
+        return;
+    }
+    // about a bucket per vertex, the queue never has more than n items
+    buckets = std::clamp<size_t>(std::bit_ceil(csr.num_vertices()), 64, 1 << 20);
+
+    // the histogram of the edge weights approximates how the queue items are
+    // spread, a bucket with much more than average edges means long scans
+    auto histogram = std::vector<size_t>(buckets, 0);
+    auto scale = buckets / (max_weight - min_weight);
+    for (auto weight : csr.weights) {
+        histogram[std::min<size_t>((weight - min_weight) * scale, buckets - 1)]++;
+    }
+    size_t average = csr.num_edges() / buckets;
+    fallback = *std::max_element(histogram.begin(), histogram.end()) > 16 * average + 64;
+}
+
+MST PrimBucketQueue::compute_mst() {
+    if (fallback) {
+        auto heap = IndexedDaryHeap<4, double>(g.csr.num_vertices());
+        return prim_with_queue(g.csr, heap);
+    }
+    auto queue = BucketQueue(g.csr.num_vertices(), min_weight, max_weight, buckets);
+    return prim_with_queue(g.csr, queue);
+}
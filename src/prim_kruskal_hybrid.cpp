@@ -0,0 +1,107 @@
+#include "mst_algorithms.h"
+#include "parallel.h"
+#include "dary_heap.h"
+#include "union_find.h"
+
+namespace {
+
+// (weight, id), the pair order is the total order of edges
+using WeightedEdge = std::pair<double, EdgeId>;
+
+// Grows Prim trees from the vertexes of [begin, end) which are not in any
+// tree yet. The lightest edge leaving a tree is in the mst by the cut
+// property, so it is added to mst, when it leads out of the partition or to
+// another tree the tree stops growing. The trees only write tree_of of
+// their own partition, so the partitions can be processed in parallel.
+void local_prim(CSRGraph const& csr, VertexId begin, VertexId end,
+        std::vector<VertexId>& tree_of, std::vector<EdgeId>& mst) {
+    constexpr auto none = std::numeric_limits<VertexId>::max();
+    constexpr auto no_exit = WeightedEdge{std::numeric_limits<double>::infinity(), NoEdge};
+    // the free vertexes of the partition by the lightest edge from the tree,
+    // only the lightest of the edges which stop the tree is needed
+    auto heap = IndexedDaryHeap<4, WeightedEdge>(end - begin);
+    auto exit = no_exit;
+    for (VertexId root = begin; root < end; root++) {
+        if (tree_of[root] != none) {
+            continue;
+        }
+        auto add_vertex = [&](VertexId u) {
+            tree_of[u] = root;
+            for (size_t i = csr.offsets[u]; i < csr.offsets[u + 1]; i++) {
+                auto v = csr.neighbors[i];
+                auto edge = WeightedEdge{csr.weights[csr.edge_ids[i]], csr.edge_ids[i]};
+                bool inside = begin <= v && v < end;
+                if (inside && tree_of[v] == none) {
+                    heap.push_or_decrease(v - begin, edge);
+                } else if ((!inside || tree_of[v] != root) && edge < exit) {
+                    exit = edge;
+                }
+            }
+        };
+        add_vertex(root);
+        while (!heap.empty() && heap.top().first < exit) {
+            auto [edge, v] = heap.pop();
+            mst.push_back(edge.second);
+            add_vertex(begin + v);
+        }
+        if (exit.second != NoEdge) {
+            mst.push_back(exit.second);
+        }
+        heap.clear();
+        exit = no_exit;
+    }
+}
+
+} // namespace
+
+MST PrimKruskalHybrid::compute_mst() {
+    auto& csr = g.csr;
+    size_t n = csr.num_vertices();
+    size_t parts = std::max<size_t>(1, std::min(threads, n));
+
+    // local Prim in each partition of the vertexes
+    auto tree_of = std::vector<VertexId>(n, std::numeric_limits<VertexId>::max());
+    auto local_mst = std::vector<std::vector<EdgeId>>(parts);
+    parallel_for(parts, parts, [&](size_t, size_t first, size_t last) {
+        for (size_t p = first; p < last; p++) {
+            local_prim(csr, n * p / parts, n * (p + 1) / parts, tree_of, local_mst[p]);
+        }
+    });
+
+    // contract the trees, an edge between two trees can be chosen by both
+    auto mst = std::vector<EdgeId>{};
+    mst.reserve(n > 0 ? n - 1 : 0);
+    auto uf = ConcurrentUnionFind(n);
+    for (auto& edges : local_mst) {
+        for (auto e : edges) {
+            if (uf.unite(csr.sources[e], csr.targets[e])) {
+                mst.push_back(e);
+            }
+        }
+    }
+
+    // kruskal on the edges between the components
+    auto residual = std::vector<std::vector<WeightedEdge>>(std::max<size_t>(1, threads));
+    parallel_for(threads, csr.num_edges(), [&](size_t t, size_t first, size_t last) {
+        for (size_t e = first; e < last; e++) {
+            if (!uf.same_set(csr.sources[e], csr.targets[e])) {
+                residual[t].emplace_back(csr.weights[e], e);
+            }
+        }
+    });
+    auto edges = std::vector<WeightedEdge>{};
+    for (auto& part : residual) {
+        edges.insert(edges.end(), part.begin(), part.end());
+        part = {};
+    }
+    std::sort(edges.begin(), edges.end());
+    for (auto [weight, e] : edges) {
+        if (mst.size() + 1 >= n) {
+            break;
+        }
+        if (uf.unite(csr.sources[e], csr.targets[e])) {
+            mst.push_back(e);
+        }
+    }
+    return mst;
+}
@@ -0,0 +1,151 @@
+#include "rooted_tree.h"
+#include "union_find.h"
+
+#include <cassert>
+#include <limits>
+#include <numeric>
+
+RootedTree::RootedTree(Vertex root, std::pmr::vector<Vertex> parent, std::pmr::vector<double> parent_weight)
+    : root(root)
+    , parent(std::move(parent))
+    , parent_weight(std::move(parent_weight), resource())
+    , depth(this->parent.size(), 0, resource())
+    , child_offset(this->parent.size() + 1, 0, resource())
+    , children(this->parent.size() > 0 ? this->parent.size() - 1 : 0, resource())
+{
+    auto n = num_vertices();
+    // counting sort of the vertexes by parent
+    for (Vertex u = 0; u < n; u++) {
+        if (u != root) {
+            child_offset[this->parent[u] + 1]++;
+        }
+    }
+    std::partial_sum(child_offset.begin(), child_offset.end(), child_offset.begin());
+    auto next = std::pmr::vector<uint32_t>(child_offset.begin(), child_offset.end() - 1, resource());
+    for (Vertex u = 0; u < n; u++) {
+        if (u != root) {
+            children[next[this->parent[u]]++] = u;
+        }
+    }
+    // the children array in bfs order from the root gives parents before
+    // their children
+    if (n > 0) {
+        auto queue = std::pmr::vector<Vertex>(1, root, resource());
+        queue.reserve(n);
+        for (size_t i = 0; i < queue.size(); i++) {
+            auto u = queue[i];
+            for (auto child : children_of(u)) {
+                depth[child] = depth[u] + 1;
+                queue.push_back(child);
+            }
+        }
+    }
+}
+
+RootedTree::RootedTree(RootedTree const& other)
+    : root(other.root)
+    , parent(other.parent, other.resource())
+    , parent_weight(other.parent_weight, other.resource())
+    , depth(other.depth, other.resource())
+    , child_offset(other.child_offset, other.resource())
+    , children(other.children, other.resource())
+{ }
+
+RootedTree rooted_tree(GraphType const& tree, Vertex root) {
+    auto n = boost::num_vertices(tree);
+    auto parent = std::pmr::vector<Vertex>(n, GraphType::null_vertex());
+    auto parent_weight = std::pmr::vector<double>(n, -std::numeric_limits<double>::infinity());
+    auto order = std::vector<Vertex>{root};
+    order.reserve(n);
+    auto weight_map = get(boost::edge_weight, tree);
+    for (size_t i = 0; i < order.size(); i++) {
+        auto u = order[i];
+        for (auto edge : boost::make_iterator_range(boost::out_edges(u, tree))) {
+            auto v = boost::target(edge, tree);
+            if (v != parent[u]) {
+                parent[v] = u;
+                parent_weight[v] = weight_map[edge];
+                order.push_back(v);
+            }
+        }
+    }
+    auto res = RootedTree(root, std::move(parent), std::move(parent_weight));
+    // the counting sort ordered the children by number, the order of the
+    // adjacency lists is restored from the bfs order
+    auto next = std::vector<uint32_t>(res.child_offset.begin(), res.child_offset.end() - 1);
+    for (size_t i = 1; i < order.size(); i++) {
+        auto v = order[i];
+        res.children[next[res.parent[v]]++] = v;
+    }
+    return res;
+}
+
+RootedTree build_fbt(size_t vertexes, std::span<std::tuple<Vertex, Vertex, double> const> edges,
+        std::pmr::memory_resource* resource) {
+    constexpr auto none = std::numeric_limits<uint32_t>::max();
+    auto parent = std::pmr::vector<Vertex>(vertexes, GraphType::null_vertex(), resource);
+    auto parent_weight = std::pmr::vector<double>(vertexes, -std::numeric_limits<double>::infinity(), resource);
+    parent.reserve(2 * vertexes);
+    parent_weight.reserve(2 * vertexes);
+    // the fbt vertex of each component of the current round
+    auto to_fbt = std::pmr::vector<Vertex>(vertexes, resource);
+    std::iota(to_fbt.begin(), to_fbt.end(), 0);
+    auto cur_edges = std::pmr::vector<std::tuple<Vertex, Vertex, double>>(edges.begin(), edges.end(), resource);
+    size_t components = vertexes;
+
+    auto min_weight = std::pmr::vector<double>(resource);
+    auto min_target = std::pmr::vector<Vertex>(resource);
+    auto label = std::pmr::vector<uint32_t>(resource);
+    while (components > 1) {
+        // the lightest edge of each component
+        min_weight.assign(components, std::numeric_limits<double>::infinity());
+        min_target.assign(components, GraphType::null_vertex());
+        for (auto [u, v, weight] : cur_edges) {
+            if (min_target[u] == GraphType::null_vertex() || weight < min_weight[u]) {
+                min_weight[u] = weight;
+                min_target[u] = v;
+            }
+            if (min_target[v] == GraphType::null_vertex() || weight < min_weight[v]) {
+                min_weight[v] = weight;
+                min_target[v] = u;
+            }
+        }
+        auto uf = UnionFind(components, resource);
+        for (Vertex u = 0; u < components; u++) {
+            assert(min_target[u] != GraphType::null_vertex()); // the tree is connected
+            uf.unite(u, min_target[u]);
+        }
+
+        // the merged components are numbered by their smallest member
+        label.assign(components, none);
+        size_t merged = 0;
+        for (Vertex u = 0; u < components; u++) {
+            auto root = uf.find(u);
+            if (label[root] == none) {
+                label[root] = merged++;
+            }
+            label[u] = label[root];
+        }
+        auto first_new = parent.size();
+        parent.resize(first_new + merged, GraphType::null_vertex());
+        parent_weight.resize(first_new + merged, -std::numeric_limits<double>::infinity());
+        for (Vertex u = 0; u < components; u++) {
+            parent[to_fbt[u]] = first_new + label[u];
+            parent_weight[to_fbt[u]] = min_weight[u];
+        }
+        to_fbt.resize(merged);
+        std::iota(to_fbt.begin(), to_fbt.end(), first_new);
+
+        // the edges between different components stay
+        size_t kept = 0;
+        for (auto [u, v, weight] : cur_edges) {
+            if (label[u] != label[v]) {
+                cur_edges[kept++] = {label[u], label[v], weight};
+            }
+        }
+        cur_edges.resize(kept);
+        components = merged;
+    }
+    Vertex root = parent.empty() ? 0 : parent.size() - 1;
+    return RootedTree(root, std::move(parent), std::move(parent_weight));
+}
@@ -0,0 +1,140 @@
+#include "sliding_window_msf.h"
+#include "union_find.h"
+
+#include <algorithm>
+#include <cassert>
+
+SlidingWindowMSF::SlidingWindowMSF(size_t vertexes)
+    : vertexes(vertexes)
+    , sources()
+    , targets()
+    , weights()
+    , free_slots()
+    , window()
+    , additions()
+    , older_count(0)
+    , forest(vertexes)
+    , tree_weight(0)
+    , tree_edges(0)
+{ }
+
+void SlidingWindowMSF::push(VertexId u, VertexId v, double weight) {
+    Slot e;
+    if (free_slots.empty()) {
+        e = weights.size();
+        sources.push_back(u);
+        targets.push_back(v);
+        weights.push_back(weight);
+        forest.add_node(weight);
+    } else {
+        e = free_slots.back();
+        free_slots.pop_back();
+        sources[e] = u;
+        targets[e] = v;
+        weights[e] = weight;
+        // the node of a free slot is not linked
+        forest.set_weight(node(e), weight);
+    }
+    window.push_back(e);
+    apply(e, false);
+}
+
+void SlidingWindowMSF::pop() {
+    assert(!window.empty());
+    if (older_count == 0) {
+        // all additions are newer, undone from the newest and reapplied as
+        // older, so the oldest ends on the top
+        auto edges = std::vector<Slot>{};
+        while (!additions.empty()) {
+            edges.push_back(undo().edge);
+        }
+        for (auto e : edges) {
+            apply(e, true);
+        }
+    } else if (!additions.back().older) {
+        // undo until as many older as newer additions are undone or no older
+        // is left, then reapply the newer ones below the older ones, each in
+        // its previous order
+        auto newer = std::vector<Slot>{};
+        auto older = std::vector<Slot>{};
+        do {
+            auto addition = undo();
+            (addition.older ? older : newer).push_back(addition.edge);
+        } while (older_count > 0 && newer.size() != older.size());
+        for (auto it = newer.rbegin(); it != newer.rend(); it++) {
+            apply(*it, false);
+        }
+        for (auto it = older.rbegin(); it != older.rend(); it++) {
+            apply(*it, true);
+        }
+    }
+    auto addition = undo();
+    assert(addition.edge == window.front());
+    window.pop_front();
+    free_slots.push_back(addition.edge);
+}
+
+double SlidingWindowMSF::kruskal_weight() const {
+    auto edges = std::vector<Slot>(window.begin(), window.end());
+    std::sort(edges.begin(), edges.end(), [&](Slot a, Slot b) {
+        return weights[a] < weights[b];
+    });
+    auto uf = UnionFind(vertexes);
+    double res = 0;
+    for (auto e : edges) {
+        if (uf.unite(sources[e], targets[e])) {
+            res += weights[e];
+        }
+    }
+    return res;
+}
+
+void SlidingWindowMSF::link(Slot e) {
+    forest.link(sources[e], node(e));
+    forest.link(node(e), targets[e]);
+    tree_weight += weights[e];
+    tree_edges++;
+}
+
+void SlidingWindowMSF::cut(Slot e) {
+    forest.cut(sources[e], node(e));
+    forest.cut(node(e), targets[e]);
+    tree_weight -= weights[e];
+    tree_edges--;
+}
+
+void SlidingWindowMSF::apply(Slot e, bool older) {
+    auto addition = Addition{e, older, false, no_slot};
+    auto u = sources[e];
+    auto v = targets[e];
+    if (u != v) {
+        // the vertex nodes weigh -inf, so the heaviest node of a path is an
+        // edge
+        auto heaviest = forest.path_max(u, v);
+        if (heaviest == LinkCutTree::none) {
+            link(e);
+            addition.linked = true;
+        } else if (forest.weight_of(heaviest) > weights[e]
+                || (forest.weight_of(heaviest) == weights[e] && heaviest > node(e))) {
+            addition.replaced = heaviest - vertexes;
+            cut(addition.replaced);
+            link(e);
+            addition.linked = true;
+        }
+    }
+    older_count += older;
+    additions.push_back(addition);
+}
+
+SlidingWindowMSF::Addition SlidingWindowMSF::undo() {
+    auto addition = additions.back();
+    additions.pop_back();
+    if (addition.linked) {
+        cut(addition.edge);
+        if (addition.replaced != no_slot) {
+            link(addition.replaced);
+        }
+    }
+    older_count -= addition.older;
+    return addition;
+}
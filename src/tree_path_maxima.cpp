@@ -3,51 +3,96 @@
 // modified to fit our graphs and work in c++
 
 #include "tree_path_maxima.h"
+#include <algorithm>
+#include <array>
 #include <bit>
+#include <cassert>
+#include <mutex>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
 
-TreePathMaxima::TreePathMaxima(std::vector<BottomUpQuery> queries, LCA& lca)
-    : tree(lca.graph)
+namespace {
+
+// fills the medians of all sets smaller than the table size in increasing
+// order, the median of S follows from the median of S without its highest
+// element, which is smaller and so already filled
+constexpr void fill_median_table(std::span<uint8_t> table) {
+    for (size_t S = 1; S < table.size(); S++) {
+        size_t high = std::bit_width(S) - 1;
+        size_t rest = S ^ (size_t{1} << high);
+        size_t median = high;
+        if (rest != 0) {
+            median = table[rest];
+            if (std::popcount(rest) % 2 == 1) {
+                // the median moves to the next element of S
+                size_t above = rest & ~((size_t{2} << median) - 1);
+                median = above != 0 ? std::countr_zero(above) : high;
+            }
+        }
+        table[S] = median;
+    }
+}
+
+// the table of a depth is a prefix of the tables of larger depths, so one
+// table serves all the small depths
+constexpr size_t small_median_table_depth = 10;
+
+constexpr auto small_median_table = [] {
+    auto table = std::array<uint8_t, size_t{2} << small_median_table_depth>{};
+    fill_median_table(table);
+    return table;
+}();
+
+struct MedianTableCache {
+    std::array<std::once_flag, median_table_max_depth + 1> built;
+    std::array<std::vector<uint8_t>, median_table_max_depth + 1> tables;
+};
+
+} // namespace
+
+std::span<uint8_t const> cached_median_table(size_t depth) {
+    if (depth <= small_median_table_depth) {
+        return std::span(small_median_table).first(size_t{2} << depth);
+    }
+    assert(depth <= median_table_max_depth);
+    static auto cache = MedianTableCache{};
+    std::call_once(cache.built[depth], [&] {
+        auto table = std::vector<uint8_t>(size_t{2} << depth, 0);
+        fill_median_table(table);
+        cache.tables[depth] = std::move(table);
+    });
+    return cache.tables[depth];
+}
+
+TreePathMaxima::TreePathMaxima(std::span<BottomUpQuery const> queries, LCA& lca)
+    : tree(lca.tree)
     , root(lca.root)
     , depth()
     , lca(lca)
-    , queries(queries)
-    , first_query(boost::num_vertices(tree), None)
-    , next_query(queries.size(), None)
-    , query_sets(boost::num_vertices(tree), 0ul)
-    , answer_sets(boost::num_vertices(tree), 0ul)
-    , answers(queries.size())
-    , rows()
+    , queries(queries.begin(), queries.end(), lca.resource())
+    , first_query(tree.num_vertices(), None, lca.resource())
+    , next_query(queries.size(), None, lca.resource())
+    , query_sets(tree.num_vertices(), 0ul, lca.resource())
+    , answer_sets(tree.num_vertices(), 0ul, lca.resource())
+    , answers(queries.size(), lca.resource())
+    , rows(lca.resource())
     , median_table()
-    , T()
-    , visit_stack()
-      , weight_to_parent(boost::num_vertices(tree), -std::numeric_limits<double>::infinity())
+    , visit_stack(lca.resource())
+    , weight_to_parent(tree.num_vertices(), -std::numeric_limits<double>::infinity(), lca.resource())
 {
     compute_parent_weights();
     depth = lca.depth(queries[0].leaf);
-    rows.resize(depth + 1, {});
-    T.resize((1ul << depth) + 1, 0ul);
-    median_table.resize(1ul<<(depth + 1), 0ul);
+    rows.resize(depth + 1);
+    median_table = cached_median_table(depth);
     visit_stack.resize(depth + 1);
-    compute_median_table(depth);
     assign_queries_to_leafs();
     propagate_query_sets_up();
     visit(root, 0ul);
 }
 
 void TreePathMaxima::compute_parent_weights() {
-    auto weight_map = get(boost::edge_weight, tree);
-    for (auto edge : boost::make_iterator_range(boost::edges(tree))) {
-        auto u = boost::source(edge, tree);
-        auto v = boost::target(edge, tree);
-        auto u_parent = lca.parrent(u);
-        auto v_parent = lca.parrent(u);
-        auto weight = weight_map[edge];
-        if (v == u_parent) {
-            weight_to_parent[u] = weight;
-        } else if (u == v_parent) {
-            weight_to_parent[v] = weight;
-        }
-    }
+    weight_to_parent = tree.parent_weight;
 }
 
 size_t TreePathMaxima::binary_search(double w, size_t S) {
@@ -73,10 +118,8 @@ void TreePathMaxima::visit(Vertex v, size_t S) { // S = S of parent
         auto lsb_pos = std::countr_zero(tmp);
         answers[i] = visit_stack[lsb_pos];
     }
-    for (auto child : boost::make_iterator_range(boost::adjacent_vertices(v, tree))) {
-        if (child != lca.parrent(v)) {
-            visit(child, S);
-        }
+    for (auto child : tree.children_of(v)) {
+        visit(child, S);
     }
 }
 
@@ -95,41 +138,8 @@ void TreePathMaxima::assign_queries_to_leafs() {
     }
 }
 
-size_t TreePathMaxima::subsets(size_t n,size_t k,size_t p) {
-    // Stores the subsets of size k of {0,...,n-1} in T,
-    // starting in position p, and returns p plus their number.
-    if (n < k || n > (1ul << 62)) {
-        return p;
-    }
-    if (k == 0ul) {
-        T[p] = 0ul;
-        return p + 1;
-    }
-    size_t q = subsets(n - 1, k - 1, p);
-    for (size_t i = p; i < q; i++) {
-        T[i] |= 1ul<<(n-1);
-    }
-    return subsets(n - 1, k, q);
-}
-
-void TreePathMaxima::compute_median_table(size_t h) {
-    for (size_t s = 0; s <= h; s++) {
-        for (size_t k = 0; k <= s; k++) {
-            size_t p = subsets(h - s, k, 0);
-            size_t q = subsets(s, k, p);
-            q = subsets(s, k + 1, q);
-            for (size_t i = 0; i < p; i++) {
-                size_t b = (1 << (s + 1)) * T[i] + (1<<s); // fixed high bits
-                for (size_t j = p; j < q; j++) {
-                    median_table[b + T[j]] = s; // variable low bits
-                }
-            }
-        }
-    }
-}
-
 void TreePathMaxima::propagate_query_sets_up() {
-    auto found = std::vector<size_t>(boost::num_vertices(tree), None);
+    auto found = std::pmr::vector<size_t>(tree.num_vertices(), None, lca.resource());
     for (size_t cur_d = depth; cur_d > 0; cur_d--) {
         size_t parent_d = cur_d - 1;
         size_t parent_mask = ~(1ul<<parent_d);
@@ -160,3 +170,222 @@ std::vector<std::vector<size_t>> TreePathMaxima::query_per_leaf() {
     }
     return leaf_to_queries;
 }
+
+// operations on the multi word sets of TreePathMaximaWide, bit i of a set is
+// bit i % 64 of word i / 64
+
+#ifndef __BMI2__
+// the position of the set bit of each rank in a byte
+constexpr auto select_in_byte = [] {
+    auto table = std::array<std::array<uint8_t, 8>, 256>{};
+    for (size_t b = 0; b < 256; b++) {
+        size_t rank = 0;
+        for (size_t i = 0; i < 8; i++) {
+            if (b & (1ul << i)) {
+                table[b][rank++] = i;
+            }
+        }
+    }
+    return table;
+}();
+#endif
+
+// the position of the set bit of rank r, x must have more than r bits set
+static size_t select_in_word(uint64_t x, size_t r) {
+#ifdef __BMI2__
+    return std::countr_zero(_pdep_u64(uint64_t{1} << r, x));
+#else
+    for (size_t shift = 0; ; shift += 8) {
+        auto byte = (x >> shift) & 0xff;
+        size_t count = std::popcount(byte);
+        if (r < count) {
+            return shift + select_in_byte[byte][r];
+        }
+        r -= count;
+    }
+#endif
+}
+
+static size_t select(uint64_t const* S, size_t words, size_t r) {
+    for (size_t i = 0; i < words; i++) {
+        size_t count = std::popcount(S[i]);
+        if (r < count) {
+            return 64 * i + select_in_word(S[i], r);
+        }
+        r -= count;
+    }
+    return None;
+}
+
+static size_t count(uint64_t const* S, size_t words) {
+    size_t res = 0;
+    for (size_t i = 0; i < words; i++) {
+        res += std::popcount(S[i]);
+    }
+    return res;
+}
+
+// removes the elements smaller than j
+static void clear_below(uint64_t* S, size_t words, size_t j) {
+    std::fill(S, S + std::min(j / 64, words), 0);
+    if (j / 64 < words) {
+        S[j / 64] &= ~((uint64_t{1} << (j % 64)) - 1);
+    }
+}
+
+// removes the elements from j up
+static void clear_from(uint64_t* S, size_t words, size_t j) {
+    if (j / 64 < words) {
+        S[j / 64] &= (uint64_t{1} << (j % 64)) - 1;
+        std::fill(S + j / 64 + 1, S + words, 0);
+    }
+}
+
+// the smallest element at least j
+static size_t first_from(uint64_t const* S, size_t words, size_t j) {
+    for (size_t i = j / 64; i < words; i++) {
+        auto word = i == j / 64 ? S[i] & (~uint64_t{0} << (j % 64)) : S[i];
+        if (word != 0) {
+            return 64 * i + std::countr_zero(word);
+        }
+    }
+    return None;
+}
+
+// down of TreePathMaxima, the addition carries over the words
+static void down(uint64_t const* a, uint64_t const* b, uint64_t* res, size_t words) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < words; i++) {
+        auto x = a[i] | ~b[i];
+        auto sum = a[i] + x;
+        auto next_carry = static_cast<uint64_t>(sum < a[i]);
+        sum += carry;
+        next_carry |= static_cast<uint64_t>(sum < carry);
+        res[i] = b[i] & (~(a[i] | b[i]) ^ sum);
+        carry = next_carry;
+    }
+}
+
+TreePathMaximaWide::TreePathMaximaWide(std::span<BottomUpQuery const> queries, LCA& lca)
+    : tree(lca.tree)
+    , root(lca.root)
+    , depth(lca.depth(queries[0].leaf))
+    , words_per_set(depth / 64 + 1)
+    , lca(lca)
+    , queries(queries.begin(), queries.end(), lca.resource())
+    , first_query(tree.num_vertices(), None, lca.resource())
+    , next_query(queries.size(), None, lca.resource())
+    , query_sets(tree.num_vertices() * words_per_set, 0, lca.resource())
+    , answers(queries.size(), lca.resource())
+    , rows(depth + 1, lca.resource())
+    , visit_stack(depth + 1, lca.resource())
+    , weight_to_parent(tree.num_vertices(), -std::numeric_limits<double>::infinity(), lca.resource())
+{
+    compute_parent_weights();
+    assign_queries_to_leafs();
+    propagate_query_sets_up();
+    visit_all();
+}
+
+void TreePathMaximaWide::compute_parent_weights() {
+    weight_to_parent = tree.parent_weight;
+}
+
+size_t TreePathMaximaWide::binary_search(double w, uint64_t* S) {
+    // Returns max({j in S | weight[P[j]]>w} union {0})
+    size_t n = count(S, words_per_set);
+    if (n == 0) return 0;
+    // the median has n / 2 smaller elements in S
+    size_t j = select(S, words_per_set, n / 2);
+    while (n > 1) {
+        if (weight(visit_stack[j]) > w) {
+            clear_below(S, words_per_set, j);
+            n -= n / 2;
+        } else {
+            clear_from(S, words_per_set, j);
+            n /= 2;
+        }
+        j = select(S, words_per_set, n / 2);
+    }
+    return (weight(visit_stack[j]) > w) ? j : 0;
+}
+
+void TreePathMaximaWide::visit_all() {
+    auto W = words_per_set;
+    // row d + 1 is the answer set of the vertex in depth d of the current
+    // path, row 0 is the empty set above the root
+    auto path_sets = std::pmr::vector<uint64_t>((depth + 2) * W, 0, lca.resource());
+    auto scratch = std::pmr::vector<uint64_t>(W, lca.resource());
+    // the index of the next child in tree.children of the vertex in each
+    // depth of the path
+    auto next = std::pmr::vector<uint32_t>(depth + 1, lca.resource());
+
+    auto enter = [&](Vertex v, size_t d) {
+        visit_stack[d] = v; // push current node on stack
+        auto parent_set = path_sets.data() + d * W;
+        auto S = parent_set + W;
+        down(query_set(v), parent_set, scratch.data(), W);
+        size_t k = binary_search(weight(v), scratch.data());
+        std::copy(parent_set, parent_set + W, scratch.data());
+        clear_from(scratch.data(), W, k + 1);
+        scratch[d / 64] |= uint64_t{1} << (d % 64);
+        down(query_set(v), scratch.data(), S, W);
+        for (size_t i = first_query[v]; i != None; i = next_query[i]) {
+            auto pos = first_from(S, W, lca.depth(queries[i].ancestor) + 1);
+            answers[i] = visit_stack[pos];
+        }
+        next[d] = tree.child_offset[v];
+    };
+
+    enter(root, 0);
+    size_t d = 0;
+    while (true) {
+        if (next[d] == tree.child_offset[visit_stack[d] + 1]) {
+            if (d == 0) {
+                break;
+            }
+            d--;
+            continue;
+        }
+        auto child = tree.children[next[d]++];
+        d++;
+        enter(child, d);
+    }
+}
+
+void TreePathMaximaWide::assign_queries_to_leafs() {
+    for (size_t i = 0; i < queries.size(); i++) {
+        auto query = queries[i];
+        if (first_query[query.leaf] == None) {
+            rows[depth].push_back(query.leaf);
+        }
+        next_query[i] = first_query[query.leaf];
+        first_query[query.leaf] = i;
+
+        // set the predecessor bit in the query set
+        auto bit_index = lca.depth(query.ancestor);
+        query_set(query.leaf)[bit_index / 64] |= uint64_t{1} << (bit_index % 64);
+    }
+}
+
+void TreePathMaximaWide::propagate_query_sets_up() {
+    auto found = std::pmr::vector<size_t>(tree.num_vertices(), None, lca.resource());
+    for (size_t cur_d = depth; cur_d > 0; cur_d--) {
+        size_t parent_d = cur_d - 1;
+        for (auto u : rows[cur_d]) {
+            auto parent = lca.parrent(u);
+            auto parent_set = query_set(parent);
+            auto u_set = query_set(u);
+            for (size_t i = 0; i < words_per_set; i++) {
+                parent_set[i] |= u_set[i];
+            }
+            parent_set[parent_d / 64] &= ~(uint64_t{1} << (parent_d % 64));
+
+            // save the parrent for the next depth iteration
+            if (found[parent] != cur_d) {
+                rows[parent_d].push_back(parent);
+                found[parent] = cur_d;
+            }
+        }
+    }
+}
@@ -5,9 +5,21 @@
 #include "tree_path_maxima.h"
 #include "utils.h"
 #include "mst_verify.h"
+#include "offline_lca.h"
+#include "rooted_tree.h"
+#include "bucket_queue.h"
+#include "dary_heap.h"
+#include "union_find.h"
+#include "dynamic_mst.h"
+#include "sliding_window_msf.h"
 
+#include <filesystem>
+#include <fstream>
 #include <limits>
+#include <random>
+#include <set>
 #include <stdexcept>
+#include <thread>
 
 using namespace boost::ut;
 
@@ -41,12 +53,12 @@ int main() {
     "lca/euler_tour"_test = [] {
         auto t = test_tree();
         auto expected_nodes = std::vector<size_t>{0,1,3,1,4,1,0,2,5,2,6,2,0};
-        auto expected_height = std::vector<size_t>{0,1,1,2,2,2,2};
-        auto expected_first_visit = std::vector<size_t>{0,1,7,2,4,8,10};
+        auto expected_height = std::vector<uint32_t>{0,1,1,2,2,2,2};
+        auto expected_first_visit = std::vector<uint32_t>{0,1,7,2,4,8,10};
         auto lca = LCA(t, 0);
-        expect(expected_nodes == lca.euler_tour);
-        expect(expected_height == lca.height);
-        expect(expected_first_visit == lca.first_visit);
+        expect(std::ranges::equal(expected_nodes, lca.euler_tour));
+        expect(std::ranges::equal(expected_height, lca.height));
+        expect(std::ranges::equal(expected_first_visit, lca.first_visit));
     };
 
     "lca/query"_test = [] {
@@ -65,6 +77,43 @@ int main() {
         }
     };
 
+    "lca/many"_test = [] {
+        // deep enough for blocks of several positions and the sparse table
+        auto edges = std::vector<std::pair<int, int>>{};
+        auto weights = std::vector<double>{};
+        for (int v = 1; v < 600; v++) {
+            edges.emplace_back(v % 3 == 0 ? v - 1 : v / 2, v);
+            weights.push_back(v);
+        }
+        auto t = GraphType(edges.begin(), edges.end(), weights.begin(), 600);
+        auto lca = LCA(t, 0);
+        auto queries = std::vector<std::pair<Vertex, Vertex>>{};
+        for (Vertex u = 0; u < 600; u += 7) {
+            for (Vertex v = 1; v < 600; v += 13) {
+                queries.emplace_back(u, v);
+            }
+        }
+        auto res = lca.lca_many(queries);
+        expect(res == offline_lca(lca, queries));
+        expect(res == offline_lca(LCA(t, 0, false), queries));
+        for (size_t i = 0; i < queries.size(); i++) {
+            auto [u, v] = queries[i];
+            expect(res[i] == lca.lca(u, v));
+            // walking up from the deeper vertex
+            while (lca.depth(u) > lca.depth(v)) {
+                u = lca.parrent(u);
+            }
+            while (lca.depth(v) > lca.depth(u)) {
+                v = lca.parrent(v);
+            }
+            while (u != v) {
+                u = lca.parrent(u);
+                v = lca.parrent(v);
+            }
+            expect(res[i] == u);
+        }
+    };
+
     "lca/naive"_test = [] {
         auto t = test_tree();
         Vertex root = 0;
@@ -153,6 +202,144 @@ int main() {
         expect(tm.query_sets[6] == n_bit(1));
     };
 
+    "TreePathMaxima/wide"_test = [] {
+        auto t = test_tree();
+        auto queries = std::vector<BottomUpQuery>{{3, 0}, {3, 1}, {4, 1}, {5, 0}, {6, 2}, {4, 0}};
+        auto lca = LCA(t, 0);
+        auto tm = TreePathMaxima(queries, lca);
+        auto wide = TreePathMaximaWide(queries, lca);
+        expect(tm.answers == wide.answers);
+    };
+
+    "TreePathMaxima/median_table"_test = [] {
+        for (size_t depth : {0, 3, 10, 11, 14}) {
+            auto table = cached_median_table(depth);
+            expect(table.size() == size_t{2} << depth);
+            for (size_t S = 1; S < table.size(); S++) {
+                // drop the popcount(S) / 2 smallest elements
+                auto rest = S;
+                for (int i = 0; i < std::popcount(S) / 2; i++) {
+                    rest &= rest - 1;
+                }
+                expect(table[S] == std::countr_zero(rest));
+            }
+            expect(cached_median_table(depth).data() == table.data());
+        }
+        auto tables = std::vector<std::span<uint8_t const>>(4);
+        auto threads = std::vector<std::thread>{};
+        for (auto& table : tables) {
+            threads.emplace_back([&table] {
+                table = cached_median_table(16);
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        for (auto& table : tables) {
+            expect(table.data() == tables[0].data());
+        }
+    };
+
+    "TreePathMaxima/wide_deep_tree"_test = [] {
+        // all leafs in depth 100, the vertexes in depth divisible by 20
+        // have two children, the others one
+        auto edges = std::vector<std::pair<int, int>>{};
+        auto weights = std::vector<double>{};
+        auto parent = std::vector<int>{-1};
+        auto row = std::vector<int>{0};
+        for (int d = 0; d < 100; d++) {
+            auto next_row = std::vector<int>{};
+            for (auto u : row) {
+                for (int c = 0; c < (d % 20 == 0 ? 2 : 1); c++) {
+                    int v = parent.size();
+                    parent.push_back(u);
+                    edges.emplace_back(u, v);
+                    weights.push_back((v * 7919) % 1009 + v * 1e-6);
+                    next_row.push_back(v);
+                }
+            }
+            row = next_row;
+        }
+        auto t = GraphType(edges.begin(), edges.end(), weights.begin(), parent.size());
+        auto weight_to_parent = [&](int v) {
+            return weights[v - 1];
+        };
+        auto queries = std::vector<BottomUpQuery>{};
+        auto expected = std::vector<double>{};
+        for (auto leaf : row) {
+            auto max = -std::numeric_limits<double>::infinity();
+            auto u = leaf;
+            for (int d = 99; d >= 0; d--) {
+                max = std::max(max, weight_to_parent(u));
+                u = parent[u];
+                if (d % 7 == 0) {
+                    queries.push_back({static_cast<Vertex>(leaf), static_cast<Vertex>(u)});
+                    expected.push_back(max);
+                }
+            }
+        }
+        auto lca = LCA(t, 0);
+        auto tm = TreePathMaximaWide(queries, lca);
+        expect(tm.words_per_set == 2);
+        for (size_t i = 0; i < queries.size(); i++) {
+            expect(tm.weight(tm.answers[i]) == expected[i]);
+        }
+    };
+
+    "mst_verify/forest_path_maxima"_test = [] {
+        // trees {0, 1, 2}, {3, 4}, {5} and {6, 7, 8, 9}
+        auto forest = std::vector<std::tuple<Vertex, Vertex, double>>{
+            {0, 1, 3.0}, {1, 2, 1.0}, {3, 4, 2.0}, {6, 7, 0.5}, {7, 8, 4.0}, {7, 9, 1.5}
+        };
+        auto queries = std::vector<std::tuple<Vertex, Vertex, double>>{
+            {0, 2, 0.0}, {2, 1, 0.0}, {4, 3, 0.0}, {8, 9, 0.0}, {6, 9, 0.0}, {2, 3, 0.0}, {5, 0, 0.0}, {7, 7, 0.0}
+        };
+        auto inf = std::numeric_limits<double>::infinity();
+        auto expected = std::vector<double>{3.0, 1.0, 2.0, 4.0, 1.5, inf, inf, -inf};
+        for (auto method : {LCAMethod::rmq, LCAMethod::offline}) {
+            expect(std::ranges::equal(forest_path_maxima(10, forest, queries, method), expected));
+        }
+    };
+
+    "mst_verify/deep_path"_test = [] {
+        // path spanning tree with queries between random vertexes
+        size_t n = 3000;
+        auto edges = std::vector<std::pair<int, int>>{};
+        auto weights = std::vector<double>{};
+        for (size_t v = 1; v < n; v++) {
+            edges.emplace_back(v - 1, v);
+            weights.push_back((v * 7919) % 10007);
+        }
+        auto t = GraphType(edges.begin(), edges.end(), weights.begin(), n);
+        auto queries = std::vector<std::tuple<Vertex, Vertex, double>>{};
+        auto rng = std::mt19937{7};
+        auto dist = std::uniform_int_distribution<Vertex>(0, n - 1);
+        while (queries.size() < 2000) {
+            auto u = dist(rng);
+            auto v = dist(rng);
+            if (u != v) {
+                queries.push_back({u, v, 0.0});
+            }
+        }
+        auto verify = MSTVerify(t, queries);
+        // the fbt of a path is shallow, so by default the median tables are
+        // used and with no median tables the wide query sets
+        auto depth = LCA(verify.fbt, true).max_depth();
+        expect(depth > 0 && depth <= median_table_max_depth);
+        auto narrow = verify.path_maxima();
+        auto wide = verify.path_maxima(0);
+        for (size_t i = 0; i < queries.size(); i++) {
+            auto [u, v, w] = queries[i];
+            auto [lo, hi] = std::minmax(u, v);
+            auto expected = -std::numeric_limits<double>::infinity();
+            for (auto e = lo; e < hi; e++) {
+                expected = std::max(expected, weights[e]);
+            }
+            expect(narrow[i] == expected);
+            expect(wide[i] == expected);
+        }
+    };
+
     "st_to_fbt/simple_tree"_test = [] {
         auto t = test_tree();
         auto [graph, leaf_map, root] = st_to_fbt(t);
@@ -179,6 +366,27 @@ int main() {
         expect(root == 9);
     };
 
+    "st_to_fbt/build_fbt"_test = [] {
+        // random tree, every borůvka round has to merge components
+        size_t n = 500;
+        auto edges = std::vector<std::tuple<Vertex, Vertex, double>>{};
+        for (Vertex v = 1; v < n; v++) {
+            edges.push_back({(v * 7919) % 499 % v, v, static_cast<double>((v * 31) % 97)});
+        }
+        auto fbt = build_fbt(n, edges);
+        expect(fbt.root == fbt.num_vertices() - 1);
+        expect(fbt.parent[fbt.root] == GraphType::null_vertex());
+        for (Vertex u = 0; u < fbt.num_vertices(); u++) {
+            if (u < n) {
+                // the leafs are the tree vertexes, all in the same depth
+                expect(fbt.children_of(u).empty());
+                expect(fbt.depth[u] == fbt.depth[0]);
+            } else {
+                expect(fbt.children_of(u).size() >= 2);
+            }
+        }
+    };
+
     "mst_verify/transform_queries"_test = [] {
         auto t = test_tree();
         auto old_weight_map = get(boost::edge_weight, t);
@@ -187,7 +395,7 @@ int main() {
         // auto expected_res = std::vector<double>{1.2, 3.1,};
         auto expected_res = std::vector<BottomUpQuery>{{3, 8}, {4,8}, {4, 9}, {5, 9},};
         auto mv = MSTVerify(t, queries);
-        auto lca = LCA(mv.fbt, mv.fbt_root);
+        auto lca = LCA(mv.fbt);
         auto res = mv.transform_queries(lca);
         expect(res.size() == expected_res.size());
         for (size_t i = 0; i < res.size(); i++) {
@@ -212,20 +420,547 @@ int main() {
         expect(expected_res == heavy);
     };
 
+    "mst_verify/verify_mst"_test = [] {
+        // the test tree with edge (0, 1) of weight 4.0 and three more edges
+        auto sources = std::vector<VertexId>{0, 0, 1, 1, 2, 2, 3, 5, 4};
+        auto targets = std::vector<VertexId>{1, 2, 3, 4, 5, 6, 4, 0, 2};
+        auto weights = std::vector<double>{4.0, 2.3, 0.9, 1.2, 3.1, 2.8, 1.5, 5.0, 0.1};
+        auto csr = build_csr(7, sources, targets, weights);
+        auto mst = std::vector<std::pair<VertexId, VertexId>>{{0, 2}, {1, 3}, {1, 4}, {2, 5}, {2, 6}, {4, 2}};
+        auto cert = verify_mst(csr, mst);
+        expect(cert.is_minimal());
+        expect(is_close(cert.tree_weight, 10.4));
+
+        // (1, 4) replaced by (0, 1), which is heavier than (4, 2)
+        auto tree = std::vector<std::pair<VertexId, VertexId>>{{0, 2}, {1, 3}, {0, 1}, {2, 5}, {2, 6}, {4, 2}};
+        cert = verify_mst(csr, tree);
+        expect(cert.is_spanning_tree() && !cert.is_minimal());
+        expect(cert.violations.size() == 2);
+        auto offline_cert = verify_mst(csr, tree, LCAMethod::offline);
+        expect(offline_cert.violations == cert.violations);
+
+        tree.pop_back();
+        expect(!verify_mst(csr, tree).spanning);
+        tree.push_back({6, 1});
+        expect(verify_mst(csr, tree).missing_edges.size() == 1);
+        mst.push_back({3, 4});
+        expect(verify_mst(csr, mst).cycle_edge == 6);
+    };
+
     "randomKKT/remove_heavy_edges"_test = [] {
-        auto t = test_tree();
-        auto old_weight_map = get(boost::edge_weight, t);
-        old_weight_map[boost::edge(0, 1, t).first] = 4.0;
-        boost::add_edge(3, 4, 0.2, t);
-        boost::add_edge(5, 0, 0.2, t);
-        auto forest = std::unordered_set<double>{0.9, 1.2, 4.0, 3.1, 2.8, 2.3};
-        auto removed = std::unordered_set<double>{3.1, 1.2};
-        // dump_as_dot(std::cout, t);
-        auto g = remove_heavy_edges(t, forest);
-        // dump_as_dot(std::cout, g);
-        auto weight_map = get(boost::edge_weight, g);
-        for (auto edge : boost::make_iterator_range(boost::edges(g))) {
-            expect(!removed.contains(weight_map[edge]));
+        // the test tree with edge (0, 1) of weight 4.0 and three more edges
+        auto sources = std::vector<VertexId>{0, 0, 1, 1, 2, 2, 3, 5, 4};
+        auto targets = std::vector<VertexId>{1, 2, 3, 4, 5, 6, 4, 0, 2};
+        auto weights = std::vector<double>{4.0, 2.3, 0.9, 1.2, 3.1, 2.8, 1.5, 5.0, 0.1};
+        auto csr = build_csr(7, sources, targets, weights);
+        auto graph = KKTGraph{};
+        graph.vertexes = 7;
+        graph.sources.assign(sources.begin(), sources.end());
+        graph.targets.assign(targets.begin(), targets.end());
+        graph.ids = {0, 1, 2, 3, 4, 5, 6, 7, 8};
+        auto forest = std::pmr::vector<EdgeId>{5, 4, 3, 2, 1, 0};
+        // (3, 4) and (5, 0) are heavier than the paths, (4, 2) is light
+        auto expected = std::vector<EdgeId>{0, 1, 2, 3, 4, 5, 8};
+        auto res = remove_heavy_edges(graph, forest, csr);
+        expect(std::ranges::equal(res.ids, expected));
+        expect(res.sources.size() == expected.size());
+    };
+
+    "randomKKT/duplicate_weights"_test = [] {
+        // many edges share the weight, ties have to be broken consistently
+        auto edges = EdgeList{};
+        edges.vertexes = 60;
+        for (VertexId u = 0; u < 60; u++) {
+            for (VertexId v = u + 1; v < 60; v += 1 + u % 3) {
+                edges.sources.push_back(u);
+                edges.targets.push_back(v);
+                edges.weights.push_back((u * 7 + v * 3) % 4);
+            }
+        }
+        auto g = build_graph(edges);
+        auto kkt = RandomKKT(g);
+        for (size_t i = 0; i < 10; i++) {
+            auto mst = kkt.compute_mst();
+            expect(std::get<std::vector<EdgeId>>(mst).size() == 59);
+            expect(is_close(kkt.mst_weight(mst), g.mst_weight()));
+        }
+    };
+
+    "arena/grows_to_peak"_test = [] {
+        auto arena = Arena(64);
+        {
+            auto run = std::pmr::vector<uint64_t>(1000, 1, arena.resource());
+            expect(arena.peak_bytes() >= 8000);
+        }
+        arena.reset();
+        // the run didn't fit, the next one does
+        auto size = arena.buffer_size();
+        expect(size >= 8000);
+        {
+            auto run = std::pmr::vector<uint64_t>(1000, 2, arena.resource());
+        }
+        arena.reset();
+        expect(arena.buffer_size() == size);
+    };
+
+    "randomKKT/arena"_test = [] {
+        // the arena is released after every run, so it can be reused
+        auto edges = EdgeList{};
+        edges.vertexes = 200;
+        for (VertexId u = 0; u < 200; u++) {
+            for (VertexId v = u + 1; v < 200; v += 1 + u % 7) {
+                edges.sources.push_back(u);
+                edges.targets.push_back(v);
+                edges.weights.push_back((u * 31 + v * 17) % 101);
+            }
+        }
+        auto g = build_graph(edges);
+        auto kkt = RandomKKTArena(g);
+        for (size_t i = 0; i < 5; i++) {
+            auto mst = kkt.compute_mst();
+            expect(std::get<std::vector<EdgeId>>(mst).size() == 199);
+            expect(is_close(kkt.mst_weight(mst), g.mst_weight()));
+        }
+        // the footprint is the peak of the graphs and of the verification
+        auto stats = kkt.stats();
+        expect(stats.size() == 3 && stats[0].first == "peak_arena_bytes");
+        expect(std::stoul(stats[1].second) > 0 && std::stoul(stats[2].second) > 0);
+        expect(std::stoul(stats[0].second) == std::stoul(stats[1].second) + std::stoul(stats[2].second));
+    };
+
+    "algorithms/factory_names"_test = [] {
+        // the bench filters by the factory names before constructing
+        auto edges = EdgeList{};
+        edges.vertexes = 3;
+        edges.sources = {0, 1};
+        edges.targets = {1, 2};
+        edges.weights = {1.0, 2.0};
+        auto g = build_graph(edges);
+        for (auto& [name, make] : get_algorithm_factories(2)) {
+            auto alg = make(g);
+            expect(alg->name == name);
+            expect(is_close(alg->mst_weight(alg->compute_mst()), 3.0));
+        }
+    };
+
+    "dary_heap/decrease_key"_test = [] {
+        auto heap = IndexedDaryHeap<4, double>(100);
+        for (uint32_t i = 0; i < 100; i++) {
+            heap.push_or_decrease(i, (i * 37) % 100 + 100.0);
+        }
+        // every third item gets lower key, larger keys are ignored
+        for (uint32_t i = 0; i < 100; i += 3) {
+            heap.push_or_decrease(i, (i * 37) % 100);
+            heap.push_or_decrease(i, 1000.0);
+        }
+        expect(heap.size() == 100);
+        auto last = -1.0;
+        for (size_t i = 0; i < 100; i++) {
+            auto [key, item] = heap.pop();
+            expect(key >= last);
+            expect(!heap.contains(item));
+            expect(key == (item % 3 == 0 ? 0.0 : 100.0) + (item * 37) % 100);
+            last = key;
+        }
+        expect(heap.empty());
+    };
+
+    "bucket_queue/exact_min"_test = [] {
+        // few buckets, so many keys share one and are ordered by the scan
+        auto queue = BucketQueue(200, 0.0, 10.0, 4);
+        for (uint32_t i = 0; i < 200; i++) {
+            queue.push_or_decrease(i, (i * 53) % 200 / 20.0);
+        }
+        for (uint32_t i = 0; i < 200; i += 7) {
+            queue.push_or_decrease(i, 9.99);
+            queue.push_or_decrease(i, (i * 53) % 200 / 40.0);
+        }
+        auto last = -1.0;
+        for (size_t i = 0; i < 200; i++) {
+            auto [key, item] = queue.pop();
+            expect(key >= last);
+            expect(!queue.contains(item));
+            expect(key == (item * 53) % 200 / (item % 7 == 0 ? 40.0 : 20.0));
+            last = key;
+        }
+        expect(queue.empty());
+    };
+
+    "bitmap/first"_test = [] {
+        auto bitmap = HierarchicalBitmap(100000);
+        expect(bitmap.empty());
+        for (size_t i : {99999, 4097, 64, 70000}) {
+            bitmap.set(i);
+        }
+        expect(bitmap.first() == 64);
+        bitmap.reset(64);
+        expect(bitmap.first() == 4097);
+        bitmap.reset(4097);
+        bitmap.reset(70000);
+        expect(bitmap.first() == 99999);
+        bitmap.reset(99999);
+        expect(bitmap.empty());
+    };
+
+    "filter_kruskal/equal_weights"_test = [] {
+        // a path keeps the graph connected, the random edges have only ten
+        // weights, the ranges of equal weights are longer than the threshold
+        auto edges = EdgeList{};
+        edges.vertexes = 3000;
+        auto rng = std::mt19937{5};
+        auto vertex = std::uniform_int_distribution<VertexId>(0, 2999);
+        auto weight = std::uniform_int_distribution<int>(0, 9);
+        for (VertexId u = 1; u < 3000; u++) {
+            edges.sources.push_back(u - 1);
+            edges.targets.push_back(u);
+            edges.weights.push_back(weight(rng));
+        }
+        for (size_t i = 0; i < 20000; i++) {
+            edges.sources.push_back(vertex(rng));
+            edges.targets.push_back(vertex(rng));
+            edges.weights.push_back(weight(rng));
+        }
+        remove_multiedges(edges);
+        auto g = build_graph(edges);
+        auto kruskal = Kruskal(g);
+        auto expected = kruskal.mst_weight(kruskal.compute_mst());
+        auto alg = FilterKruskal(g);
+        auto mst = alg.compute_mst();
+        auto tree = std::vector<std::pair<VertexId, VertexId>>{};
+        for (auto e : std::get<std::vector<EdgeId>>(mst)) {
+            tree.emplace_back(g.csr.sources[e], g.csr.targets[e]);
+        }
+        expect(tree.size() == 2999);
+        expect(is_close(alg.mst_weight(mst), expected));
+        expect(verify_mst(g.csr, tree).is_minimal());
+    };
+
+    "kruskal_radix/signed_weights"_test = [] {
+        // negative weights, both zeros and ties, the edges have to be taken
+        // in increasing weight
+        auto values = std::vector<double>{-1e6, -3.5, -1.0, -0.25, -0.0, 0.0, 0.25, 1.0, 3.5, 1e6};
+        auto edges = EdgeList{};
+        edges.vertexes = 200;
+        for (VertexId u = 0; u < 200; u++) {
+            for (VertexId v = u + 1; v < 200; v += 1 + (u * 7) % 11) {
+                edges.sources.push_back(u);
+                edges.targets.push_back(v);
+                edges.weights.push_back(values[(u * 31 + v * 17) % values.size()]);
+            }
+        }
+        auto g = build_graph(edges);
+        auto kruskal = Kruskal(g);
+        auto expected = kruskal.mst_weight(kruskal.compute_mst());
+        auto alg = KruskalRadix(g);
+        auto mst = std::get<std::vector<EdgeId>>(alg.compute_mst());
+        expect(mst.size() == 199);
+        expect(is_close(alg.mst_weight(mst), expected));
+        for (size_t i = 1; i < mst.size(); i++) {
+            expect(g.csr.weights[mst[i - 1]] <= g.csr.weights[mst[i]]);
+        }
+    };
+
+    "load_edge_list/chunks"_test = [] {
+        // the body is long enough for four chunks, so the chunk boundaries
+        // split lines, every fifth line is blank and every odd line ends
+        // with crlf
+        auto file = std::filesystem::temp_directory_path() / "mst_tests_chunks.txt";
+        auto expected = EdgeList{};
+        expected.vertexes = 1000;
+        {
+            auto os = std::ofstream(file, std::ios::binary);
+            os << "1000 30000\n";
+            for (VertexId i = 0; i < 30000; i++) {
+                auto u = (i * 7919) % 1000;
+                auto v = (i * 104729 + 1) % 1000;
+                auto w = (i % 997) / 8.0;
+                os << u << (i % 3 ? " " : " \t") << v << ' ' << w << (i % 2 ? "\r\n" : "\n");
+                if (i % 5 == 0) {
+                    os << (i % 2 ? "\r\n" : "  \n");
+                }
+                expected.sources.push_back(u);
+                expected.targets.push_back(v);
+                expected.weights.push_back(w);
+            }
+        }
+        for (size_t threads : {1, 4}) {
+            auto edges = load_edge_list(file, threads);
+            expect(edges.vertexes == 1000);
+            expect(edges.sources == expected.sources);
+            expect(edges.targets == expected.targets);
+            expect(edges.weights == expected.weights);
+        }
+        std::filesystem::remove(file);
+    };
+
+    "load_edge_list/multiedges_and_errors"_test = [] {
+        auto file = std::filesystem::temp_directory_path() / "mst_tests_edges.txt";
+        auto write = [&](std::string const& content) {
+            auto os = std::ofstream(file, std::ios::binary | std::ios::trunc);
+            os << content;
+        };
+
+        // the reversed and repeated edges keep the weight of the first one
+        write("4 5\n0 1 1.5\n1 0 2.5\n3 2 0.5\n0 1 3.0\n2 3 1.0\n");
+        auto edges = load_edge_list(file, 2);
+        expect(edges.size() == 5);
+        remove_multiedges(edges);
+        expect(edges.sources == std::vector<VertexId>{0, 3});
+        expect(edges.targets == std::vector<VertexId>{1, 2});
+        expect(edges.weights == std::vector<double>{1.5, 0.5});
+
+        write("3 1\n0 3 1.0\n");
+        expect(throws([&] { load_edge_list(file); }));
+        write("");
+        expect(throws([&] { load_edge_list(file); }));
+        write("# no header\n0 1 1.0\n");
+        expect(throws([&] { load_edge_list(file); }));
+        std::filesystem::remove(file);
+    };
+
+    "binary_graph/corrupted"_test = [] {
+        // a triangle with a double edge, the arrays start after the 32 byte
+        // header and the weights of the 4 edges
+        auto sources = std::vector<VertexId>{0, 1, 2, 0};
+        auto targets = std::vector<VertexId>{1, 2, 0, 1};
+        auto weights = std::vector<double>{1.0, 2.0, 3.0, 0.5};
+        auto csr = build_csr(3, sources, targets, weights);
+        auto file = std::filesystem::temp_directory_path() / "mst_tests_corrupted.bin";
+        auto offsets_pos = 32 + 4 * sizeof(double);
+        auto neighbors_pos = offsets_pos + 4 * sizeof(uint64_t) + 8 * sizeof(VertexId);
+        auto overwrite = [&](size_t pos, auto value) {
+            write_binary_graph(file, csr, BinaryGraphDeduplicated);
+            auto fs = std::fstream(file, std::ios::binary | std::ios::in | std::ios::out);
+            fs.seekp(pos);
+            fs.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        };
+        uint32_t flags = 0;
+
+        write_binary_graph(file, csr, BinaryGraphDeduplicated);
+        expect(open_binary_graph(file, flags).num_edges() == 4);
+        // the last offset isn't 2m
+        overwrite(offsets_pos + 3 * sizeof(uint64_t), uint64_t{7});
+        expect(throws([&] { open_binary_graph(file, flags); }));
+        // the offsets decrease
+        overwrite(offsets_pos + sizeof(uint64_t), uint64_t{9});
+        expect(throws([&] { open_binary_graph(file, flags); }));
+        // a neighbor out of range
+        overwrite(neighbors_pos, VertexId{3});
+        expect(throws([&] { open_binary_graph(file, flags); }));
+        // the first slot of vertex 0 is edge 0 to vertex 1, pointing it to
+        // vertex 2 keeps the ids in range but not consistent with the edge
+        overwrite(neighbors_pos, VertexId{2});
+        expect(throws([&] { open_binary_graph(file, flags); }));
+        // the slot of edge 0 taken by edge 3, which has the same endpoints,
+        // puts edge 3 in the adjacency of vertex 0 twice
+        overwrite(neighbors_pos + 8 * sizeof(VertexId), EdgeId{3});
+        expect(throws([&] { open_binary_graph(file, flags); }));
+        // more vertexes than the ids can number, the vertex count is at byte
+        // 16 of the header
+        overwrite(16, uint64_t{1} << 40);
+        expect(throws([&] { open_binary_graph(file, flags); }));
+        // an edge count whose size wraps around
+        overwrite(24, uint64_t{1} << 61);
+        expect(throws([&] { open_binary_graph(file, flags); }));
+
+        // without the flag the second (0, 1) edge is removed on load
+        write_binary_graph(file, csr, BinaryGraphConnected);
+        auto g = parse_graph(file);
+        expect(g.csr.num_edges() == 3);
+        expect(is_close(g.mst_weight(), 3.0));
+        std::filesystem::remove(file);
+    };
+
+    "parallel_boruvka/threads"_test = [] {
+        // a long cycle with chords needs several rounds, the weights repeat
+        auto edges = EdgeList{};
+        edges.vertexes = 2000;
+        for (VertexId u = 0; u < 2000; u++) {
+            edges.sources.push_back(u);
+            edges.targets.push_back((u + 1) % 2000);
+            edges.weights.push_back(u % 7);
+            if (u % 3 == 0) {
+                edges.sources.push_back(u);
+                edges.targets.push_back((u * 37 + 11) % 2000);
+                edges.weights.push_back((u * 13) % 5);
+            }
+        }
+        remove_multiedges(edges);
+        auto g = build_graph(edges);
+        auto kruskal = Kruskal(g);
+        auto expected = kruskal.mst_weight(kruskal.compute_mst());
+        for (size_t threads : {0, 1, 3, 8}) {
+            auto alg = ParallelBoruvka(g, threads);
+            auto mst = alg.compute_mst();
+            expect(std::get<std::vector<EdgeId>>(mst).size() == 1999);
+            expect(is_close(alg.mst_weight(mst), expected));
+        }
+    };
+
+    "prim_kruskal_hybrid/partitions"_test = [] {
+        // the trees stop on the partition borders, so every thread count
+        // has different residual graph
+        auto edges = EdgeList{};
+        edges.vertexes = 300;
+        for (VertexId u = 0; u < 300; u++) {
+            for (VertexId v = u + 1; v < 300; v += 1 + (u * 13) % 17) {
+                edges.sources.push_back(u);
+                edges.targets.push_back(v);
+                edges.weights.push_back((u * 29 + v * 11) % 23);
+            }
+        }
+        auto g = build_graph(edges);
+        for (size_t threads : {1, 2, 3, 8, 300}) {
+            auto alg = PrimKruskalHybrid(g, threads);
+            auto mst = alg.compute_mst();
+            expect(std::get<std::vector<EdgeId>>(mst).size() == 299);
+            expect(is_close(alg.mst_weight(mst), g.mst_weight()));
+        }
+    };
+
+    "dynamic_mst/random_updates"_test = [] {
+        // the two halves are connected only by the inserted edges
+        auto edges = EdgeList{};
+        edges.vertexes = 60;
+        auto present = std::set<std::pair<VertexId, VertexId>>{};
+        auto rng = std::mt19937{7};
+        auto weight_dist = std::uniform_int_distribution<int>(0, 50);
+        for (VertexId u = 0; u < 60; u++) {
+            for (VertexId v = u + 1; v < 60; v += 3 + u % 5) {
+                if (u < 30 && v >= 30) {
+                    break;
+                }
+                edges.sources.push_back(u);
+                edges.targets.push_back(v);
+                edges.weights.push_back(weight_dist(rng));
+                present.insert({u, v});
+            }
+        }
+        auto g = build_graph(edges);
+        auto kruskal = Kruskal(g);
+        auto dynamic = DynamicMST(g.csr, kruskal.mst_edge_ids(kruskal.compute_mst()));
+        expect(is_close(dynamic.total_weight(), g.mst_weight()));
+
+        auto vertex_dist = std::uniform_int_distribution<VertexId>(0, 59);
+        for (size_t i = 0; i < 300; i++) {
+            if (i % 3 == 0) {
+                auto e = std::uniform_int_distribution<EdgeId>(0, edges.size() - 1)(rng);
+                edges.weights[e] -= weight_dist(rng) / 10;
+                dynamic.decrease_weight(e, edges.weights[e]);
+            } else {
+                auto u = vertex_dist(rng);
+                auto v = vertex_dist(rng);
+                if (u == v || !present.insert({std::min(u, v), std::max(u, v)}).second) {
+                    continue;
+                }
+                edges.sources.push_back(u);
+                edges.targets.push_back(v);
+                edges.weights.push_back(weight_dist(rng));
+                expect(dynamic.insert_edge(u, v, edges.weights.back()) == edges.size() - 1);
+            }
+            auto current = build_graph(edges);
+            expect(is_close(dynamic.total_weight(), current.mst_weight()));
+            auto tree = dynamic.tree_edges();
+            auto uf = UnionFind(60);
+            for (auto e : tree) {
+                expect(uf.unite(edges.sources[e], edges.targets[e]));
+            }
+            expect(tree.size() == (uf.same_set(0, 59) ? 59u : 58u));
+        }
+        expect(throws([&] { dynamic.decrease_weight(0, edges.weights[0] + 1); }));
+        for (auto swap : dynamic.swaps()) {
+            expect(swap.removed != swap.added);
+        }
+    };
+
+    "sliding_window_msf/random_stream"_test = [] {
+        // the stream repeats vertex pairs and weights
+        auto rng = std::mt19937{11};
+        auto vertex_dist = std::uniform_int_distribution<VertexId>(0, 39);
+        auto weight_dist = std::uniform_int_distribution<int>(0, 20);
+        for (size_t window : {1, 7, 50}) {
+            auto msf = SlidingWindowMSF(40);
+            for (size_t i = 0; i < 600; i++) {
+                msf.push(vertex_dist(rng), vertex_dist(rng), weight_dist(rng));
+                if (msf.size() > window) {
+                    msf.pop();
+                }
+                expect(msf.size() == std::min(i + 1, window));
+                expect(is_close(msf.total_weight(), msf.kruskal_weight()));
+            }
+            while (!msf.empty()) {
+                msf.pop();
+                expect(is_close(msf.total_weight(), msf.kruskal_weight()));
+            }
+            expect(msf.forest_size() == 0);
+        }
+    };
+
+    "union_find/sequential_and_concurrent"_test = [] {
+        auto uf = UnionFind(10);
+        auto cuf = ConcurrentUnionFind(10);
+        auto unions = std::vector<std::pair<VertexId, VertexId>>{
+            {0, 1}, {2, 3}, {1, 3}, {4, 5}, {0, 2}, {6, 7}, {5, 7}, {9, 8}
+        };
+        auto merges = std::vector<bool>{true, true, true, true, false, true, true, true};
+        for (size_t i = 0; i < unions.size(); i++) {
+            auto [u, v] = unions[i];
+            expect(uf.unite(u, v) == merges[i]);
+            expect(cuf.unite(u, v) == merges[i]);
+        }
+        for (VertexId u = 0; u < 10; u++) {
+            for (VertexId v = 0; v < 10; v++) {
+                // the sets are {0..3}, {4..7} and {8, 9}
+                bool same = u / 4 == v / 4;
+                expect(uf.same_set(u, v) == same);
+                expect(cuf.same_set(u, v) == same);
+            }
+        }
+    };
+
+    "union_find/concurrent_threads"_test = [] {
+        // a random graph with a giant component and many small ones, the
+        // threads unite edges of the same vertexes at once
+        size_t n = 20000;
+        auto rng = std::mt19937{11};
+        auto vertex = std::uniform_int_distribution<VertexId>(0, n - 1);
+        auto edges = std::vector<std::pair<VertexId, VertexId>>(15000);
+        for (auto& e : edges) {
+            e = {vertex(rng), vertex(rng)};
+        }
+        auto uf = UnionFind(n);
+        for (auto [u, v] : edges) {
+            uf.unite(u, v);
+        }
+        size_t components = 0;
+        for (VertexId u = 0; u < n; u++) {
+            components += uf.find(u) == u;
+        }
+        for (size_t threads : {2, 4, 8}) {
+            for (size_t round = 0; round < 5; round++) {
+                auto cuf = ConcurrentUnionFind(n);
+                auto merges = std::atomic<size_t>(0);
+                parallel_for(threads, edges.size(), [&](size_t, size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; i++) {
+                        merges += cuf.unite(edges[i].first, edges[i].second);
+                    }
+                });
+                expect(merges == n - components);
+                // the same root in the sequential one means the same root in
+                // the concurrent one, and both have the same number of sets
+                constexpr auto none = std::numeric_limits<VertexId>::max();
+                auto root_of = std::vector<VertexId>(n, none);
+                size_t concurrent_components = 0;
+                for (VertexId u = 0; u < n; u++) {
+                    auto root = uf.find(u);
+                    if (root_of[root] == none) {
+                        root_of[root] = cuf.find(u);
+                    }
+                    expect(cuf.find(u) == root_of[root]);
+                    concurrent_components += cuf.find(u) == u;
+                }
+                expect(concurrent_components == components);
+            }
         }
     };
 }